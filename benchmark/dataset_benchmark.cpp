@@ -122,6 +122,24 @@ static void BM_Dataset_plus(benchmark::State &state) {
 }
 BENCHMARK(BM_Dataset_plus)->RangeMultiplier(2)->Range(2 << 9, 2 << 12);
 
+// Elementwise arithmetic on contiguous data runs in parallel above a size
+// threshold, this shows the crossover.
+static void BM_Variable_plus_equal(benchmark::State &state) {
+  const gsl::index size = state.range(0);
+  auto a = makeVariable<Data::Value>({Dim::X, size});
+  const auto b = makeVariable<Data::Value>({Dim::X, size});
+  for (auto _ : state) {
+    a += b;
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+  // Loading 2, storing 1.
+  state.SetBytesProcessed(state.iterations() * size * 3 * sizeof(double));
+}
+BENCHMARK(BM_Variable_plus_equal)
+    ->RangeMultiplier(4)
+    ->Range(2 << 9, 2 << 23)
+    ->UseRealTime();
+
 static void BM_Dataset_multiply(benchmark::State &state) {
   gsl::index nSpec = state.range(0);
   gsl::index nPoint = 1024;
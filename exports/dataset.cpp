@@ -662,4 +662,15 @@ PYBIND11_MODULE(dataset, m) {
       py::call_guard<py::gil_scoped_release>());
   m.def("filter", py::overload_cast<const Dataset &, const Variable &>(&filter),
         py::call_guard<py::gil_scoped_release>());
+  m.def("apply_over",
+        [](Dataset &self, const Dimension dim, const py::function &f) {
+          // The callable runs on the worker threads and needs the GIL,
+          // which is held only while it executes.
+          py::gil_scoped_release release;
+          applyOver(self, dim, [&f](Slice<Dataset> slice) {
+            py::gil_scoped_acquire acquire;
+            f(slice);
+          });
+        },
+        py::arg("dataset"), py::arg("dim"), py::arg("function"));
 }
@@ -250,6 +250,15 @@ class TestDataset(unittest.TestCase):
         np.testing.assert_array_equal(dataset[Data.Value, "data"].numpy, np.array([1,3]))
         np.testing.assert_array_equal(dataset[Coord.X].numpy, np.array([2,1]))
 
+    def test_apply_over(self):
+        def compute(view):
+            view[Data.Value, "data2"] = np.exp(view[Data.Value, "data1"].numpy)
+        apply_over(self.dataset, Dim.Z, compute)
+        np.testing.assert_array_equal(self.dataset[Data.Value, "data2"].numpy,
+                                      np.exp(self.reference_data1))
+        np.testing.assert_array_equal(self.dataset[Data.Value, "data1"].numpy,
+                                      self.reference_data1)
+
 class TestDatasetExamples(unittest.TestCase):
     def test_table_example(self):
         table = Dataset()
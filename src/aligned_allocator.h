@@ -5,6 +5,8 @@
 /// National Laboratory, and European Spallation Source ERIC.
 
 // from https://stackoverflow.com/a/12942652/1458281
+#include <type_traits>
+
 #include "memory_pool.h"
 
 enum class Alignment : size_t {
@@ -87,6 +89,20 @@ public:
   template <class U>
   AlignedAllocator(const AlignedAllocator<U, Align> &) noexcept {}
 
+  /// Returns an allocator that skips value-initialization of trivial elements.
+  /// Use only for containers that are overwritten right after construction,
+  /// e.g., by a parallel copy, and swap the data into a container with a
+  /// default allocator afterwards. Copies of the container use the default.
+  static AlignedAllocator uninitialized() noexcept {
+    AlignedAllocator allocator;
+    allocator.m_uninitialized = true;
+    return allocator;
+  }
+
+  AlignedAllocator select_on_container_copy_construction() const noexcept {
+    return {};
+  }
+
   size_type max_size() const noexcept {
     return (size_type(~0) - size_type(Align)) / sizeof(T);
   }
@@ -112,11 +128,21 @@ public:
     return detail::deallocate_aligned_memory(p);
   }
 
+  template <class U> void construct(U *p) {
+    if constexpr (std::is_trivially_default_constructible<U>::value)
+      if (m_uninitialized)
+        return;
+    ::new (reinterpret_cast<void *>(p)) U();
+  }
+
   template <class U, class... Args> void construct(U *p, Args &&... args) {
     ::new (reinterpret_cast<void *>(p)) U(std::forward<Args>(args)...);
   }
 
   void destroy(pointer p) { p->~T(); }
+
+private:
+  bool m_uninitialized{false};
 };
 
 template <typename T, Alignment Align> class AlignedAllocator<const T, Align> {
@@ -0,0 +1,313 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <deque>
+
+#include "convolution.h"
+#include "except.h"
+#include "fft.h"
+
+namespace {
+// Kernels longer than this use the FFT path.
+constexpr gsl::index fftThreshold = 64;
+// Number of elements of the inner dimensions processed jointly. The innermost
+// loops run over such a block and can be vectorized.
+constexpr gsl::index blockSize = 256;
+
+/// Memory layout of a variable relative to `dim`: `outer` blocks of `size`
+/// rows, each row consisting of `inner` contiguous elements. If any
+/// dimension has extent 0 there are no blocks.
+struct Lines {
+  Lines(const Dimensions &dims, const Dim dim)
+      : size(dims.size(dim)), inner(dims.offset(dim)),
+        outer(dims.volume() == 0 ? 0 : dims.volume() / (size * inner)) {}
+  gsl::index size;
+  gsl::index inner;
+  gsl::index outer;
+};
+
+/// Calls `f(offset, begin, end)` in parallel for all outer blocks and all
+/// blocks [begin, end) of the inner dimensions.
+template <class F> void forEachBlock(const Lines &lines, F f) {
+  const gsl::index blocks = (lines.inner + blockSize - 1) / blockSize;
+#pragma omp parallel for collapse(2)
+  for (gsl::index o = 0; o < lines.outer; ++o) {
+    for (gsl::index b = 0; b < blocks; ++b) {
+      const gsl::index begin = b * blockSize;
+      f(o * lines.size * lines.inner, begin,
+        std::min(begin + blockSize, lines.inner));
+    }
+  }
+}
+
+template <class Kernel>
+Variable transformLines(const Variable &var, const Dim dim, Kernel kernel) {
+  if (!var.dimensions().contains(dim))
+    throw dataset::except::DimensionNotFoundError(var.dimensions(), dim);
+  // Constant data has no raw values, read from a temporary dense copy.
+  const auto in = var.isConstant() ? toDense(var) : var;
+  Variable out(in);
+  if (in.valueTypeIs<Data::Value>())
+    kernel(in.get<const Data::Value>().data(), out.get<Data::Value>().data(),
+           Lines(in.dimensions(), dim));
+  else if (in.valueTypeIs<Data::Variance>())
+    kernel(in.get<const Data::Variance>().data(),
+           out.get<Data::Variance>().data(), Lines(in.dimensions(), dim));
+  else
+    throw std::runtime_error("Cannot apply kernel: Only Data::Value and "
+                             "Data::Variance are supported.");
+  return out;
+}
+
+void convolveDirect(const double *in, double *out, const Lines &lines,
+                    const std::vector<double> &kernel) {
+  const gsl::index length = kernel.size();
+  const gsl::index center = (length - 1) / 2;
+  const gsl::index size = lines.size;
+  const gsl::index inner = lines.inner;
+  forEachBlock(lines, [&](const gsl::index offset, const gsl::index begin,
+                          const gsl::index end) {
+    const auto *src = in + offset;
+    auto *dst = out + offset;
+    for (gsl::index i = 0; i < size; ++i)
+      for (gsl::index j = begin; j < end; ++j)
+        dst[i * inner + j] = 0.0;
+    for (gsl::index k = 0; k < length; ++k) {
+      const double w = kernel[k];
+      const gsl::index shift = center - k;
+      const gsl::index first = std::max(gsl::index{0}, -shift);
+      const gsl::index last = std::min(size, size - shift);
+      if (inner == 1) {
+        for (gsl::index i = first; i < last; ++i)
+          dst[i] += w * src[i + shift];
+      } else {
+        for (gsl::index i = first; i < last; ++i)
+          for (gsl::index j = begin; j < end; ++j)
+            dst[i * inner + j] += w * src[(i + shift) * inner + j];
+      }
+    }
+  });
+}
+
+void convolveFFT(const double *in, double *out, const Lines &lines,
+                 const std::vector<double> &kernel) {
+  const gsl::index center = (kernel.size() - 1) / 2;
+  const gsl::index size = lines.size;
+  const gsl::index inner = lines.inner;
+  const gsl::index n = detail::fftSize(size + kernel.size() - 1);
+  std::vector<std::complex<double>> kernelFT(kernel.begin(), kernel.end());
+  kernelFT.resize(n);
+  detail::fft(kernelFT.data(), n);
+  const gsl::index count = lines.outer * inner;
+#pragma omp parallel
+  {
+    std::vector<std::complex<double>> buffer(n);
+#pragma omp for
+    for (gsl::index line = 0; line < count; ++line) {
+      const gsl::index offset = (line / inner) * size * inner + line % inner;
+      const auto *src = in + offset;
+      auto *dst = out + offset;
+      for (gsl::index i = 0; i < size; ++i)
+        buffer[i] = src[i * inner];
+      std::fill(buffer.begin() + size, buffer.end(), 0.0);
+      detail::fft(buffer.data(), n);
+      for (gsl::index i = 0; i < n; ++i)
+        buffer[i] *= kernelFT[i];
+      detail::fft(buffer.data(), n, true);
+      for (gsl::index i = 0; i < size; ++i)
+        dst[i * inner] = buffer[i + center].real() / n;
+    }
+  }
+}
+
+/// Sum over the window [i - center, i - center + window) clipped to the
+/// input, computed as a running sum in O(n). If `normalize` is set the sum is
+/// divided by the number of elements in the window (or its square if `squared`
+/// is set, as required for variances).
+///
+/// Subtracting a NaN or inf leaving the window does not cancel it, so blocks
+/// containing non-finite values are summed directly in O(n * window) instead.
+void windowSum(const double *in, double *out, const Lines &lines,
+               const gsl::index window, const bool normalize,
+               const bool squared) {
+  const gsl::index center = (window - 1) / 2;
+  const gsl::index size = lines.size;
+  const gsl::index inner = lines.inner;
+  forEachBlock(lines, [&](const gsl::index offset, const gsl::index begin,
+                          const gsl::index end) {
+    const auto *src = in + offset;
+    auto *dst = out + offset;
+    if (size == 0)
+      return;
+    bool finite = true;
+    for (gsl::index i = 0; i < size; ++i)
+      for (gsl::index j = begin; j < end; ++j)
+        finite &= std::isfinite(src[i * inner + j]);
+    if (finite) {
+      for (gsl::index j = begin; j < end; ++j)
+        dst[j] = 0.0;
+      for (gsl::index i = 0; i < std::min(size, window - center); ++i)
+        for (gsl::index j = begin; j < end; ++j)
+          dst[j] += src[i * inner + j];
+      for (gsl::index i = 1; i < size; ++i) {
+        const gsl::index add = i - center + window - 1;
+        const gsl::index remove = i - center - 1;
+        for (gsl::index j = begin; j < end; ++j)
+          dst[i * inner + j] = dst[(i - 1) * inner + j];
+        if (add < size)
+          for (gsl::index j = begin; j < end; ++j)
+            dst[i * inner + j] += src[add * inner + j];
+        if (remove >= 0)
+          for (gsl::index j = begin; j < end; ++j)
+            dst[i * inner + j] -= src[remove * inner + j];
+      }
+    } else {
+      for (gsl::index i = 0; i < size; ++i) {
+        for (gsl::index j = begin; j < end; ++j)
+          dst[i * inner + j] = 0.0;
+        for (gsl::index k = std::max(gsl::index{0}, i - center);
+             k < std::min(size, i - center + window); ++k)
+          for (gsl::index j = begin; j < end; ++j)
+            dst[i * inner + j] += src[k * inner + j];
+      }
+    }
+    if (!normalize)
+      return;
+    for (gsl::index i = 0; i < size; ++i) {
+      const gsl::index count = std::min(size, i - center + window) -
+                               std::max(gsl::index{0}, i - center);
+      double scale = 1.0 / count;
+      if (squared)
+        scale *= scale;
+      for (gsl::index j = begin; j < end; ++j)
+        dst[i * inner + j] *= scale;
+    }
+  });
+}
+
+/// Maximum over the window [i - center, i - center + window) clipped to the
+/// input. Uses a monotonic queue of candidates, i.e., O(n) per line.
+void windowMax(const double *in, double *out, const Lines &lines,
+               const gsl::index window) {
+  const gsl::index center = (window - 1) / 2;
+  const gsl::index size = lines.size;
+  const gsl::index inner = lines.inner;
+  const gsl::index count = lines.outer * inner;
+#pragma omp parallel for
+  for (gsl::index line = 0; line < count; ++line) {
+    const gsl::index offset = (line / inner) * size * inner + line % inner;
+    const auto *src = in + offset;
+    auto *dst = out + offset;
+    std::deque<gsl::index> candidates;
+    gsl::index next = 0;
+    for (gsl::index i = 0; i < size; ++i) {
+      const gsl::index last = std::min(size, i - center + window);
+      for (; next < last; ++next) {
+        while (!candidates.empty() &&
+               src[candidates.back() * inner] <= src[next * inner])
+          candidates.pop_back();
+        candidates.push_back(next);
+      }
+      while (candidates.front() < i - center)
+        candidates.pop_front();
+      dst[i * inner] = src[candidates.front() * inner];
+    }
+  }
+}
+
+void checkWindow(const gsl::index window) {
+  if (window < 1)
+    throw std::runtime_error("Window size must be positive.");
+}
+} // namespace
+
+Variable convolve(const Variable &var, const Dim dim,
+                  const std::vector<double> &kernel) {
+  if (kernel.empty())
+    throw std::runtime_error("Convolution kernel must not be empty.");
+  return transformLines(
+      var, dim, [&](const double *in, double *out, const Lines &lines) {
+        if (static_cast<gsl::index>(kernel.size()) > fftThreshold)
+          convolveFFT(in, out, lines, kernel);
+        else
+          convolveDirect(in, out, lines, kernel);
+      });
+}
+
+Variable rollingSum(const Variable &var, const Dim dim,
+                    const gsl::index window) {
+  checkWindow(window);
+  return transformLines(
+      var, dim, [&](const double *in, double *out, const Lines &lines) {
+        windowSum(in, out, lines, window, false, false);
+      });
+}
+
+Variable rollingMean(const Variable &var, const Dim dim,
+                     const gsl::index window) {
+  checkWindow(window);
+  return transformLines(
+      var, dim, [&](const double *in, double *out, const Lines &lines) {
+        windowSum(in, out, lines, window, true, false);
+      });
+}
+
+Variable rollingMax(const Variable &var, const Dim dim,
+                    const gsl::index window) {
+  checkWindow(window);
+  return transformLines(
+      var, dim, [&](const double *in, double *out, const Lines &lines) {
+        windowMax(in, out, lines, window);
+      });
+}
+
+namespace {
+/// Applies `op(var, isVariance)` to all data variables depending on `dim`.
+template <class Op>
+Dataset transformData(const Dataset &d, const Dim dim, Op op) {
+  Dataset out;
+  for (const auto &var : d) {
+    if (!var.isData() || !var.dimensions().contains(dim))
+      out.insert(var);
+    else if (var.valueTypeIs<Data::Value>())
+      out.insert(op(var, false));
+    else if (var.valueTypeIs<Data::Variance>())
+      out.insert(op(var, true));
+    else
+      throw std::runtime_error("Cannot apply kernel: Only Data::Value and "
+                               "Data::Variance are supported.");
+  }
+  return out;
+}
+} // namespace
+
+Dataset convolve(const Dataset &d, const Dim dim,
+                 const std::vector<double> &kernel) {
+  std::vector<double> squared(kernel);
+  for (auto &w : squared)
+    w *= w;
+  return transformData(d, dim, [&](const Variable &var, const bool variance) {
+    return convolve(var, dim, variance ? squared : kernel);
+  });
+}
+
+Dataset rollingSum(const Dataset &d, const Dim dim, const gsl::index window) {
+  return transformData(d, dim, [&](const Variable &var, const bool) {
+    return rollingSum(var, dim, window);
+  });
+}
+
+Dataset rollingMean(const Dataset &d, const Dim dim, const gsl::index window) {
+  checkWindow(window);
+  return transformData(d, dim, [&](const Variable &var, const bool variance) {
+    return transformLines(
+        var, dim, [&](const double *in, double *out, const Lines &lines) {
+          windowSum(in, out, lines, window, true, variance);
+        });
+  });
+}
@@ -0,0 +1,41 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <vector>
+
+#include <gsl/gsl_util>
+
+#include "dataset.h"
+#include "dimension.h"
+#include "variable.h"
+
+// All functions operate along `dim` and return a result of the same shape as
+// the input, i.e., the kernel or window is centered on the output element and
+// values outside the input are treated as zero (or ignored for `rollingMean`
+// and `rollingMax`). Only Data::Value and Data::Variance are supported.
+
+/// Convolution with `kernel`. Equivalent to numpy.convolve with mode="same"
+/// if the kernel is not longer than the input along `dim`. Unlike numpy, the
+/// result has the shape of the input also for longer kernels.
+Variable convolve(const Variable &var, const Dim dim,
+                  const std::vector<double> &kernel);
+Variable rollingSum(const Variable &var, const Dim dim,
+                    const gsl::index window);
+Variable rollingMean(const Variable &var, const Dim dim,
+                     const gsl::index window);
+Variable rollingMax(const Variable &var, const Dim dim,
+                    const gsl::index window);
+
+// Dataset versions propagate variances: For a linear operation with weights w
+// the variances are transformed with weights w^2.
+Dataset convolve(const Dataset &d, const Dim dim,
+                 const std::vector<double> &kernel);
+Dataset rollingSum(const Dataset &d, const Dim dim, const gsl::index window);
+Dataset rollingMean(const Dataset &d, const Dim dim, const gsl::index window);
+
+#endif // CONVOLUTION_H
@@ -79,6 +79,11 @@ public:
   /// Returns the stored pointer.
   const DataType *get() const noexcept { return Data.get(); }
 
+  /// Returns a weak reference to the managed object.
+  std::weak_ptr<DataType> weak() const noexcept {
+    return std::atomic_load(&Data);
+  }
+
   /// Checks if *this stores a non-null pointer, i.e. whether get() != nullptr.
   explicit operator bool() const noexcept { return bool(Data); }
 
@@ -3,13 +3,18 @@
 /// @author Simon Heybrock
 /// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
 /// National Laboratory, and European Spallation Source ERIC.
+#include <map>
 #include <numeric>
 #include <set>
 
+#include <omp.h>
+
 #include "range/v3/algorithm.hpp"
 #include "range/v3/view/zip.hpp"
 
 #include "dataset.h"
+#include "event_binning.h"
+#include "parallel.h"
 
 Dataset::Dataset(const Slice<const Dataset> &view) {
   for (const auto &var : view)
@@ -345,9 +350,13 @@ template <class T1, class T2> T1 &times_equals(T1 &dataset, const T2 &other) {
           auto error_index2 = find(other, tag_id<Data::Variance>, var2.name());
           VarRef error1 = detail::makeAccess(dataset)[error_index1];
           const auto &error2 = other[error_index2];
+          const auto isDense = [](const auto &var) {
+            return !var.data().isSparse() && !var.data().isConstant();
+          };
           if ((var1.dimensions() == var2.dimensions()) &&
               (var1.dimensions() == error1.dimensions()) &&
-              (var1.dimensions() == error2.dimensions())) {
+              (var1.dimensions() == error2.dimensions()) && isDense(var1) &&
+              isDense(var2) && isDense(error1) && isDense(error2)) {
             // Optimization if all dimensions match, avoiding allocation of
             // temporaries and redundant streaming from memory of large array.
             error1.setUnit(var2.unit() * var2.unit() * error1.unit() +
@@ -729,3 +738,504 @@ Dataset filter(const Dataset &d, const Variable &select) {
       filtered.insert(var);
   return filtered;
 }
+
+void applyOver(Dataset &d, const Dim dim,
+               const std::function<void(Slice<Dataset>)> &f) {
+  if (!d.dimensions().contains(dim))
+    throw dataset::except::DimensionNotFoundError(d.dimensions(), dim);
+  // Obtaining mutable access triggers copy-on-write for shared variables and
+  // converts constant or lazy variables to dense storage. This must happen
+  // before the threads create their views.
+  auto access = detail::makeAccess(d);
+  for (gsl::index i = 0; i < d.size(); ++i)
+    access[i].data();
+
+  detail::parallelFor(d.dimensions()[dim],
+                      [&](const gsl::index i) { f(d(dim, i)); });
+}
+
+/// Splits a single event list into one list per interval of pulse time.
+std::vector<Dataset>
+splitEventList(const Dataset &events,
+               gsl::span<const std::pair<int64_t, int64_t>> intervals) {
+  const auto pulseTimes = events.get<const Data::PulseTime>();
+  std::vector<Dataset> out;
+  out.reserve(intervals.size());
+  if (std::is_sorted(pulseTimes.begin(), pulseTimes.end())) {
+    // Each interval is a contiguous range, found by binary search.
+    auto it = pulseTimes.begin();
+    for (const auto &interval : intervals) {
+      const auto begin =
+          std::lower_bound(it, pulseTimes.end(), interval.first);
+      it = std::lower_bound(begin, pulseTimes.end(), interval.second);
+      out.emplace_back(slice(events, Dim::Event, begin - pulseTimes.begin(),
+                             it - pulseTimes.begin()));
+    }
+    return out;
+  }
+
+  // Bucket events by interval with a counting sort, such that each interval
+  // is a contiguous range after a single permutation of the events.
+  const gsl::index size = pulseTimes.size();
+  std::vector<gsl::index> bucket(size, -1);
+  std::vector<gsl::index> offsets(intervals.size() + 1, 0);
+  for (gsl::index i = 0; i < size; ++i) {
+    const auto next =
+        std::upper_bound(intervals.begin(), intervals.end(), pulseTimes[i],
+                         [](const double t, const auto &interval) {
+                           return t < interval.first;
+                         });
+    if (next != intervals.begin() && pulseTimes[i] < (next - 1)->second) {
+      bucket[i] = next - intervals.begin() - 1;
+      ++offsets[bucket[i] + 1];
+    }
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<gsl::index> indices(offsets.back());
+  auto position(offsets);
+  for (gsl::index i = 0; i < size; ++i)
+    if (bucket[i] >= 0)
+      indices[position[bucket[i]]++] = i;
+  Dataset sorted;
+  for (const auto &var : events)
+    if (var.dimensions().contains(Dim::Event))
+      sorted.insert(permute(var, Dim::Event, indices));
+    else
+      sorted.insert(var);
+  for (gsl::index i = 0; i < intervals.size(); ++i)
+    out.emplace_back(slice(sorted, Dim::Event, offsets[i], offsets[i + 1]));
+  return out;
+}
+
+Dataset splitEvents(const Dataset &d, const Variable &intervals) {
+  if (intervals.dimensions().ndim() != 1)
+    throw std::runtime_error(
+        "Cannot split events: The intervals must be 1-dimensional.");
+  const auto dim = intervals.dimensions().labels()[0];
+  if (d.dimensions().contains(dim))
+    throw std::runtime_error("Cannot split events: Dataset already contains "
+                             "the dimension of the intervals.");
+  const auto bounds = intervals.get<const Coord::TimeInterval>();
+  for (gsl::index i = 0; i < bounds.size(); ++i)
+    if (bounds[i].second < bounds[i].first ||
+        (i > 0 && bounds[i].first < bounds[i - 1].second))
+      throw std::runtime_error("Cannot split events: Intervals must be sorted "
+                               "and must not overlap.");
+
+  Dataset out;
+  for (const auto &var : d) {
+    if (var.type() != tag_id<Data::Events>) {
+      out.insert(var);
+      continue;
+    }
+    auto dims = var.dimensions();
+    dims.add(dim, bounds.size());
+    auto split = makeVariable<Data::Events>(dims);
+    split.setName(var.name());
+    const auto lists = var.get<const Data::Events>();
+    auto splitLists = split.get<Data::Events>();
+    const gsl::index count = lists.size();
+#pragma omp parallel for
+    for (gsl::index i = 0; i < count; ++i) {
+      auto slices = splitEventList(lists[i], bounds);
+      for (gsl::index t = 0; t < bounds.size(); ++t)
+        splitLists[t * count + i] = std::move(slices[t]);
+    }
+    out.insert(std::move(split));
+  }
+  out.insert(intervals);
+  return out;
+}
+
+template <class Tag> std::vector<double> edgeValues(const Variable &edges) {
+  const auto x = edges.get<const Tag>();
+  return {x.begin(), x.end()};
+}
+
+std::vector<double> edgeValues(const Variable &edges) {
+  switch (edges.type()) {
+    CASE_RETURN(Coord::X, edgeValues, edges);
+    CASE_RETURN(Coord::Y, edgeValues, edges);
+    CASE_RETURN(Coord::Z, edgeValues, edges);
+    CASE_RETURN(Coord::Tof, edgeValues, edges);
+  default:
+    throw std::runtime_error("Cannot bin events: Binning along this "
+                             "coordinate has not been implemented.");
+  }
+}
+
+EventBinning::EventBinning(const Variable &edges)
+    : m_isProgression(edges.isProgression()),
+      m_bins(edges.dimensions().volume() - 1) {
+  if (edges.dimensions().ndim() != 1 || m_bins < 1)
+    throw std::runtime_error("Cannot bin events: Bin edges must be "
+                             "1-dimensional with at least two values.");
+  if (m_isProgression) {
+    m_progression = edges.progression();
+  } else {
+    m_edges = edgeValues(edges);
+    if (!std::is_sorted(m_edges.begin(), m_edges.end()))
+      throw std::runtime_error("Cannot bin events: Bin edges must be sorted.");
+  }
+}
+
+Dimensions binnedDimensions(const std::vector<Variable> &edges) {
+  Dimensions dims;
+  for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+    const auto dim = it->dimensions().labels()[0];
+    if (dims.contains(dim))
+      throw std::runtime_error(
+          "Cannot bin events: Bin edges must have distinct dimensions.");
+    dims.add(dim, it->dimensions().volume() - 1);
+  }
+  return dims;
+}
+
+Dataset makeHistogram(const std::vector<Variable> &edges,
+                      const Dimensions &dims,
+                      const std::vector<std::vector<double>> &tiles) {
+  Dataset out;
+  for (const auto &var : edges)
+    out.insert(var);
+  out.insert<Data::Value>("", dims);
+  auto counts = out.get<Data::Value>();
+  const gsl::index volume = dims.volume();
+#pragma omp parallel for
+  for (gsl::index bin = 0; bin < volume; ++bin)
+    for (const auto &tile : tiles)
+      if (!tile.empty())
+        counts[bin] += tile[bin];
+  return out;
+}
+
+Dataset binEvents(const Dataset &d, const std::vector<EventCoordinate> &coords,
+                  const std::vector<Variable> &edges) {
+  if (coords.empty() || coords.size() != edges.size())
+    throw std::runtime_error("Cannot bin events: Require one set of bin edges "
+                             "for each event coordinate.");
+  std::vector<EventBinning> binnings;
+  for (const auto &var : edges)
+    binnings.emplace_back(var);
+  const auto dims = binnedDimensions(edges);
+  std::vector<gsl::index> strides;
+  for (const auto &var : edges)
+    strides.push_back(dims.offset(var.dimensions().labels()[0]));
+
+  const Variable *events = nullptr;
+  for (const auto &var : d)
+    if (var.type() == tag_id<Data::Events>) {
+      if (events)
+        throw std::runtime_error("Cannot bin events: Dataset must not contain "
+                                 "more than one event variable.");
+      events = &var;
+    }
+  if (!events)
+    throw std::runtime_error(
+        "Cannot bin events: Dataset does not contain an event variable.");
+  const auto lists = events->get<const Data::Events>();
+  const gsl::index count = lists.size();
+  const gsl::index volume = dims.volume();
+
+  // Every thread accumulates into a private histogram, such that there is no
+  // contention on bins. The histograms are merged after all events are done.
+  std::vector<std::vector<double>> tiles(omp_get_max_threads());
+#pragma omp parallel
+  {
+    auto &tile = tiles[omp_get_thread_num()];
+    tile.resize(volume);
+    std::vector<double> coord;
+    std::vector<gsl::index> offsets;
+#pragma omp for schedule(dynamic)
+    for (gsl::index i = 0; i < count; ++i) {
+      const auto &list = lists[i];
+      const gsl::index size = list.dimensions().contains(Dim::Event)
+                                  ? list.dimensions()[Dim::Event]
+                                  : 0;
+      coord.resize(size);
+      offsets.assign(size, 0);
+      // Compute one coordinate of all events at a time such that both the
+      // transformation and the bin lookup are simple loops over events.
+      for (size_t j = 0; j < binnings.size(); ++j) {
+        coords[j](list, i, coord);
+        for (gsl::index event = 0; event < size; ++event) {
+          const auto bin = binnings[j](coord[event]);
+          offsets[event] = bin < 0 || offsets[event] < 0
+                               ? -1
+                               : offsets[event] + bin * strides[j];
+        }
+      }
+      for (const auto offset : offsets)
+        if (offset >= 0)
+          tile[offset] += 1.0;
+    }
+  }
+  return makeHistogram(edges, dims, tiles);
+}
+
+/// Weights of the bins overlapping with [lo, hi], starting at bin `first`.
+/// Partially covered bins at either end get fractional weights.
+template <class Edges>
+std::vector<std::pair<gsl::index, double>>
+integrationWeights(const Edges &x, const gsl::index size,
+                   const gsl::index first, const double lo, const double hi) {
+  std::vector<std::pair<gsl::index, double>> weights;
+  for (gsl::index i = std::max(first, gsl::index{0});
+       i < size - 1 && x[i] < hi; ++i) {
+    const double overlap = std::min(x[i + 1], hi) - std::max(x[i], lo);
+    if (overlap > 0.0)
+      weights.emplace_back(i, overlap / (x[i + 1] - x[i]));
+  }
+  return weights;
+}
+
+template <class Tag>
+std::vector<std::pair<gsl::index, double>>
+integrationWeights(const Variable &edges, const double lo, const double hi) {
+  const auto x = edges.get<const Tag>();
+  if (!std::is_sorted(x.begin(), x.end()))
+    throw std::runtime_error(
+        "Cannot integrate: Bin-edge coordinate must be sorted.");
+  const gsl::index first =
+      std::upper_bound(x.begin(), x.end(), lo) - x.begin();
+  return integrationWeights(x, x.size(), first - 1, lo, hi);
+}
+
+std::vector<std::pair<gsl::index, double>>
+integrationWeights(const Variable &edges, const double lo, const double hi) {
+  // Progressions are increasing by construction and the first bin is found in
+  // closed form, without generating the coordinate values.
+  if (edges.isProgression())
+    return integrationWeights(edges.progression(), edges.dimensions().volume(),
+                              edges.progression().lowerIndex(lo), lo, hi);
+  switch (edges.type()) {
+    CASE_RETURN(Coord::X, integrationWeights, edges, lo, hi);
+    CASE_RETURN(Coord::Y, integrationWeights, edges, lo, hi);
+    CASE_RETURN(Coord::Z, integrationWeights, edges, lo, hi);
+    CASE_RETURN(Coord::Tof, integrationWeights, edges, lo, hi);
+  default:
+    throw std::runtime_error(
+        "Integration over this coordinate has not been implemented.");
+  }
+}
+
+template <class Tag>
+Variable weightedSum(const Variable &var, const Dim dim,
+                     const std::vector<std::pair<gsl::index, double>> &weights,
+                     const bool squareWeights) {
+  if (var.isSparse() || var.isConstant() || var.isLazy()) {
+    // Convert only the part covered by the integration range to dense.
+    const gsl::index first = weights.empty() ? 0 : weights.front().first;
+    const gsl::index last = weights.empty() ? 0 : weights.back().first;
+    auto shifted(weights);
+    for (auto &weight : shifted)
+      weight.first -= first;
+    return weightedSum<Tag>(toDense(slice(var, dim, first, last + 1)), dim,
+                            shifted, squareWeights);
+  }
+  const auto &dims = var.dimensions();
+  auto out = slice(var, dim, 0);
+  // Any dimension of extent 0, not only `dim`, leaves nothing to sum.
+  if (dims.volume() == 0)
+    return out;
+  const gsl::index size = dims.size(dim);
+  const gsl::index inner = dims.offset(dim);
+  const gsl::index outer = dims.volume() / (size * inner);
+  const auto in = var.get<const Tag>();
+  auto result = out.get<Tag>();
+  // Parallelize over outer dimensions and blocks of the inner dimensions such
+  // that the innermost loop is contiguous and can be vectorized.
+  constexpr gsl::index blockSize = 256;
+  const gsl::index blocks = (inner + blockSize - 1) / blockSize;
+#pragma omp parallel for collapse(2)
+  for (gsl::index o = 0; o < outer; ++o) {
+    for (gsl::index b = 0; b < blocks; ++b) {
+      const gsl::index begin = b * blockSize;
+      const gsl::index end = std::min(begin + blockSize, inner);
+      auto *target = result.data() + o * inner;
+      const auto *source = in.data() + o * size * inner;
+      for (gsl::index j = begin; j < end; ++j)
+        target[j] = 0.0;
+      for (const auto &weight : weights) {
+        const double w =
+            squareWeights ? weight.second * weight.second : weight.second;
+        const auto *row = source + weight.first * inner;
+        for (gsl::index j = begin; j < end; ++j)
+          target[j] += w * row[j];
+      }
+    }
+  }
+  return out;
+}
+
+Dataset integrate(const Dataset &d, const Dim dim, const double lo,
+                  const double hi) {
+  if (lo > hi)
+    throw std::runtime_error(
+        "Cannot integrate: Lower bound must not exceed upper bound.");
+  gsl::index edgesIndex = -1;
+  for (gsl::index i = 0; i < d.size(); ++i)
+    if (d[i].isCoord() && coordDimension[d[i].type()] == dim)
+      edgesIndex = i;
+  if (edgesIndex == -1)
+    throw std::runtime_error(
+        "Cannot integrate: Dataset lacks a coordinate for this dimension.");
+  const auto &edges = d[edgesIndex];
+  if (edges.dimensions().ndim() != 1 ||
+      edges.dimensions().size(dim) != d.dimensions().size(dim) + 1)
+    throw std::runtime_error("Cannot integrate: Coordinate must be a "
+                             "1-dimensional bin-edge coordinate.");
+  const auto weights = integrationWeights(edges, lo, hi);
+
+  Dataset out;
+  for (const auto &var : d) {
+    if (!var.dimensions().contains(dim))
+      out.insert(var);
+    else if (var.isCoord())
+      continue; // Coordinates along the integrated dimension are dropped.
+    else if (var.valueTypeIs<Data::Value>())
+      out.insert(weightedSum<Data::Value>(var, dim, weights, false));
+    else if (var.valueTypeIs<Data::Variance>())
+      out.insert(weightedSum<Data::Variance>(var, dim, weights, true));
+    else
+      throw std::runtime_error("Cannot integrate: Only Data::Value and "
+                               "Data::Variance are supported.");
+  }
+  return out;
+}
+
+namespace {
+/// Rebins a histogram with bin edges `xold` onto the bin edges `xnew`. Old bins
+/// contribute proportionally to their overlap with new bins, with squared
+/// weights for variances.
+std::vector<double> rebinHistogram(const gsl::span<const double> xold,
+                                   const gsl::span<const double> values,
+                                   const gsl::span<const double> xnew,
+                                   const bool squareWeights) {
+  std::vector<double> out(xnew.size() - 1, 0.0);
+  gsl::index iold = 0;
+  gsl::index inew = 0;
+  const gsl::index oldSize = values.size();
+  const gsl::index newSize = out.size();
+  while (iold < oldSize && inew < newSize) {
+    const double overlap = std::min(xold[iold + 1], xnew[inew + 1]) -
+                           std::max(xold[iold], xnew[inew]);
+    if (overlap > 0.0) {
+      const double weight = overlap / (xold[iold + 1] - xold[iold]);
+      out[inew] += (squareWeights ? weight * weight : weight) * values[iold];
+    }
+    if (xnew[inew + 1] > xold[iold + 1])
+      ++iold;
+    else
+      ++inew;
+  }
+  return out;
+}
+
+/// Unit of the ratio of data and monitor.
+Unit normalizedUnit(const Unit &data, const Unit &monitor) {
+  if (monitor == Unit{Unit::Id::Dimensionless})
+    return data;
+  if (data.id() != monitor.id())
+    throw std::runtime_error(
+        "Cannot normalize: Unsupported combination of units.");
+  return {Unit::Id::Dimensionless, data.scale() / monitor.scale()};
+}
+} // namespace
+
+Dataset normalizeByMonitor(const Dataset &d, const std::string &monitorName) {
+  const auto &monitor = d[d.find(tag_id<Data::Value>, monitorName)];
+  const auto &monitorEdges = d[d.findUnique(tag<Coord::MonitorTof>)];
+  const auto &edges = d[d.findUnique(tag<Coord::Tof>)];
+  if (monitor.dimensions().ndim() != 1 ||
+      !monitor.dimensions().contains(Dim::MonitorTof))
+    throw std::runtime_error("Cannot normalize: Monitor must be "
+                             "1-dimensional along Dim::MonitorTof.");
+  if (monitorEdges.dimensions() !=
+          Dimensions(Dim::MonitorTof, monitor.dimensions().volume() + 1) ||
+      edges.dimensions() !=
+          Dimensions(Dim::Tof, d.dimensions().size(Dim::Tof) + 1))
+    throw std::runtime_error("Cannot normalize: Coordinates must be "
+                             "1-dimensional bin-edge coordinates.");
+  const auto tof = edges.get<const Coord::Tof>();
+  const auto monitorTof = monitorEdges.get<const Coord::MonitorTof>();
+  if (!std::is_sorted(tof.begin(), tof.end()) ||
+      !std::is_sorted(monitorTof.begin(), monitorTof.end()))
+    throw std::runtime_error(
+        "Cannot normalize: Bin-edge coordinates must be sorted.");
+  // Data outside the monitor range would be divided by zero.
+  if (monitorTof[0] > tof[0] ||
+      monitorTof[monitorTof.size() - 1] < tof[tof.size() - 1])
+    throw std::runtime_error("Cannot normalize: Monitor bin edges must cover "
+                             "the Tof range of the data.");
+
+  // The monitor is rebinned once, all spectra then share the result.
+  const auto monitorValues =
+      rebinHistogram(monitorTof, toDense(monitor).get<const Data::Value>(),
+                     tof, false);
+  std::vector<double> monitorVariances(monitorValues.size(), 0.0);
+  if (d.contains(tag<Data::Variance>, monitorName))
+    monitorVariances = rebinHistogram(
+        monitorTof,
+        toDense(d[d.find(tag_id<Data::Variance>, monitorName)])
+            .get<const Data::Variance>(),
+        tof, true);
+
+  std::map<std::pair<uint16_t, std::string>, Variable> normalized;
+  for (const auto &var : d) {
+    if (var.type() != tag_id<Data::Value> || var.name() == monitorName ||
+        !var.dimensions().contains(Dim::Tof))
+      continue;
+    auto value = toDense(var);
+    value.setUnit(normalizedUnit(var.unit(), monitor.unit()));
+    auto values = value.get<Data::Value>();
+    gsl::span<double> variances;
+    if (d.contains(tag<Data::Variance>, var.name())) {
+      const auto &variance = d[d.find(tag_id<Data::Variance>, var.name())];
+      if (variance.dimensions() != var.dimensions())
+        throw std::runtime_error("Cannot normalize: Dimensions of value and "
+                                 "variance do not match.");
+      auto normalizedVariance = toDense(variance);
+      const auto unit = normalizedUnit(var.unit(), monitor.unit());
+      if (unit.id() == Unit::Id::Dimensionless)
+        normalizedVariance.setUnit(
+            {Unit::Id::Dimensionless, unit.scale() * unit.scale()});
+      variances = normalizedVariance.get<Data::Variance>();
+      normalized.emplace(std::make_pair(tag_id<Data::Variance>, var.name()),
+                         std::move(normalizedVariance));
+    }
+
+    // Values and variances are updated in a single pass, with the Tof loop
+    // outside the innermost loop such that the monitor factors are computed
+    // once per bin and the innermost loop is contiguous. Variables with an
+    // extent of 0 in any dimension only get their unit converted.
+    const auto &dims = var.dimensions();
+    if (dims.volume() != 0) {
+      const gsl::index size = dims.size(Dim::Tof);
+      const gsl::index inner = dims.offset(Dim::Tof);
+      const gsl::index outer = dims.volume() / (size * inner);
+#pragma omp parallel for collapse(2)
+      for (gsl::index o = 0; o < outer; ++o) {
+        for (gsl::index t = 0; t < size; ++t) {
+          const double scale = 1.0 / monitorValues[t];
+          const double relativeVariance = monitorVariances[t] * scale * scale;
+          const gsl::index offset = (o * size + t) * inner;
+          for (gsl::index j = offset; j < offset + inner; ++j) {
+            values[j] *= scale;
+            if (!variances.empty())
+              variances[j] = variances[j] * scale * scale +
+                             values[j] * values[j] * relativeVariance;
+          }
+        }
+      }
+    }
+    normalized.emplace(std::make_pair(tag_id<Data::Value>, var.name()),
+                       std::move(value));
+  }
+
+  Dataset out;
+  for (const auto &var : d) {
+    const auto it = normalized.find(std::make_pair(var.type(), var.name()));
+    out.insert(it == normalized.end() ? var : it->second);
+  }
+  return out;
+}
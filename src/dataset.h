@@ -6,6 +6,7 @@
 #ifndef DATASET_H
 #define DATASET_H
 
+#include <functional>
 #include <vector>
 
 #include <boost/iterator/iterator_facade.hpp>
@@ -422,5 +423,41 @@ Dataset sort(const Dataset &d, const Tag t, const std::string &name = "");
 // QTableView.
 
 Dataset filter(const Dataset &d, const Variable &select);
+/// Call `f` with a mutable view of every slice of `d` along `dim`, in
+/// parallel. Slices are modified in place without copies. Variables that do
+/// not depend on `dim` are shared by all slices and must not be modified by
+/// `f`. If `f` throws, slices after the failed one may be skipped and the
+/// exception of the failed slice with the lowest index is rethrown.
+void applyOver(Dataset &d, const Dim dim,
+               const std::function<void(Slice<Dataset>)> &f);
+/// Split all event lists by pulse time into the intervals given by a
+/// Coord::TimeInterval variable. The event lists gain the dimension of
+/// `intervals` as new outer dimension, events outside all intervals are
+/// dropped. Each event list is read only once, irrespective of the number of
+/// intervals.
+Dataset splitEvents(const Dataset &d, const Variable &intervals);
+/// Computes one coordinate for all events of an event list, given the list,
+/// its index in the event variable and an output with one value per event.
+/// Must be safe to call concurrently for different lists.
+using EventCoordinate =
+    std::function<void(const Dataset &, const gsl::index, gsl::span<double>)>;
+/// Count the events of all event lists in a multi-dimensional histogram. For
+/// each dimension, `coords` provides the event coordinate and `edges` the
+/// 1-dimensional bin edges, the first dimension becomes the outermost
+/// dimension of the resulting Data::Value. Events outside the edges in any
+/// dimension are ignored.
+Dataset binEvents(const Dataset &d, const std::vector<EventCoordinate> &coords,
+                  const std::vector<Variable> &edges);
+/// Integrate over the range [lo, hi] of the bin-edge coordinate for `dim`.
+/// Bins that are only partially inside the range contribute proportionally to
+/// the covered fraction, variances are propagated with squared weights.
+Dataset integrate(const Dataset &d, const Dim dim, const double lo,
+                  const double hi);
+/// Divide all data along Dim::Tof by the monitor `monitorName`, after
+/// rebinning the monitor from Coord::MonitorTof onto the Coord::Tof bin edges.
+/// Variances of data and monitor are propagated, data variables without
+/// Dim::Tof are unchanged. The monitor edges must cover the Coord::Tof range.
+/// As for division, bins where the rebinned monitor is zero give inf or NaN.
+Dataset normalizeByMonitor(const Dataset &d, const std::string &monitorName);
 
 #endif // DATASET_H
@@ -0,0 +1,57 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <future>
+
+#include "dataset_accumulator.h"
+
+void DatasetAccumulator::add(const Dataset &d) {
+  if (m_count == 0)
+    m_sum = d;
+  else
+    m_sum += d;
+  ++m_count;
+}
+
+void DatasetAccumulator::add(Dataset &&d) {
+  if (m_count == 0)
+    m_sum = std::move(d);
+  else
+    m_sum += d;
+  ++m_count;
+}
+
+void DatasetAccumulator::add(const Dataset &chunk, const Dim dim) {
+  if (!chunk.dimensions().contains(dim))
+    return add(chunk);
+  const gsl::index extent = chunk.dimensions().size(dim);
+  for (gsl::index i = 0; i < extent; ++i) {
+    if (m_count == 0)
+      m_sum = slice(chunk, dim, i);
+    else
+      m_sum += chunk(dim, i);
+    ++m_count;
+  }
+}
+
+void DatasetAccumulator::add(
+    const gsl::index count,
+    const std::function<Dataset(const gsl::index)> &load) {
+  if (count == 0)
+    return;
+  auto next = std::async(std::launch::async, load, 0);
+  for (gsl::index i = 0; i < count; ++i) {
+    auto current = next.get();
+    if (i + 1 < count)
+      next = std::async(std::launch::async, load, i + 1);
+    add(std::move(current));
+  }
+}
+
+const Dataset &DatasetAccumulator::sum() const {
+  if (m_count == 0)
+    throw std::runtime_error("DatasetAccumulator: No dataset has been added.");
+  return m_sum;
+}
@@ -0,0 +1,45 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef DATASET_ACCUMULATOR_H
+#define DATASET_ACCUMULATOR_H
+
+#include <functional>
+
+#include <gsl/gsl_util>
+
+#include "dataset.h"
+
+/// Sums datasets, e.g., runs, that are provided one at a time instead of
+/// holding all of them in memory.
+///
+/// The first dataset becomes the sum, all further datasets are added in place,
+/// i.e., with the same rules as Dataset::operator+=. Coordinates that share
+/// data with the sum, e.g., after VariablePool::internCoordinates, are
+/// validated in O(1). Peak memory is the sum plus the dataset being added.
+class DatasetAccumulator {
+public:
+  void add(const Dataset &d);
+  void add(Dataset &&d);
+  /// Adds all slices of `chunk` along `dim`, e.g., a block of runs along
+  /// Dim::Run, without creating a temporary dataset per slice.
+  void add(const Dataset &chunk, const Dim dim);
+  /// Adds the datasets returned by `load(i)` for `i` in [0, count). Loading
+  /// the next dataset overlaps with adding the current one, which bounds peak
+  /// memory by the sum plus two datasets.
+  void add(const gsl::index count,
+           const std::function<Dataset(const gsl::index)> &load);
+
+  /// Returns the number of datasets or slices added so far.
+  gsl::index count() const { return m_count; }
+  /// Returns the sum. Throws if nothing has been added.
+  const Dataset &sum() const;
+
+private:
+  Dataset m_sum;
+  gsl::index m_count{0};
+};
+
+#endif // DATASET_ACCUMULATOR_H
@@ -407,6 +407,7 @@ INSTANTIATE(Data::Value const)
 INSTANTIATE(Data::Value const, Data::String)
 INSTANTIATE(Data::Value, Data::Int)
 INSTANTIATE(Data::Value, Data::Int const)
+INSTANTIATE(Data::Value const, Data::Variance const)
 INSTANTIATE(Data::Value, Data::Variance)
 INSTANTIATE(Data::Value, Data::Variance const)
 INSTANTIATE(Data::Variance, Data::Int)
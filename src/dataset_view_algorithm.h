@@ -0,0 +1,71 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef DATASET_VIEW_ALGORITHM_H
+#define DATASET_VIEW_ALGORITHM_H
+
+#include <algorithm>
+#include <vector>
+
+#include "dataset_view.h"
+#include "parallel.h"
+
+namespace detail {
+/// Number of items of a view processed by a single task. The partitioning
+/// is independent of the number of threads, such that reductions give
+/// identical results for any thread count.
+constexpr gsl::index viewChunkSize = 4096;
+
+/// Calls `f(chunk, begin, end)` in parallel for all chunks of the items of
+/// `view`. If `f` throws, the exception of the failed chunk with the lowest
+/// index is rethrown.
+template <class View, class F> void forEachChunk(const View &view, F f) {
+  const gsl::index size = view.size();
+  parallelFor((size + viewChunkSize - 1) / viewChunkSize,
+              [&](const gsl::index chunk) {
+                const auto begin = view.begin() + chunk * viewChunkSize;
+                const auto end =
+                    view.begin() + std::min(size, (chunk + 1) * viewChunkSize);
+                f(chunk, begin, end);
+              });
+}
+} // namespace detail
+
+/// Calls `f` for every item of `view`, in parallel. Items accessed via
+/// non-const tags may be modified. Since items of variables with fewer
+/// dimensions than the view are visited repeatedly and possibly concurrently,
+/// only variables that have all dimensions of the view may be written to. If
+/// `f` throws, the exception of the failed item with the lowest index is
+/// rethrown.
+template <class View, class F> void forEach(const View &view, F f) {
+  detail::forEachChunk(view, [&f](const gsl::index, auto it, const auto end) {
+    for (; it != end; ++it)
+      f(*it);
+  });
+}
+
+/// Returns `init` combined via `reduce` with the result of `transform` for
+/// every item of `view`, computed in parallel. The items are partitioned
+/// into chunks of fixed size and the per-chunk results are combined in
+/// order, so for non-associative operations such as floating-point addition
+/// the result is reproducible, independent of the number of threads.
+template <class View, class T, class Reduce, class Transform>
+T transformReduce(const View &view, T init, Reduce reduce,
+                  Transform transform) {
+  std::vector<T> partial(
+      (view.size() + detail::viewChunkSize - 1) / detail::viewChunkSize);
+  detail::forEachChunk(view, [&](const gsl::index chunk, auto it,
+                                 const auto end) {
+    T accumulator = transform(*it);
+    for (++it; it != end; ++it)
+      accumulator = reduce(std::move(accumulator), transform(*it));
+    partial[chunk] = std::move(accumulator);
+  });
+  for (auto &value : partial)
+    init = reduce(std::move(init), std::move(value));
+  return init;
+}
+
+#endif // DATASET_VIEW_ALGORITHM_H
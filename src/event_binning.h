@@ -0,0 +1,57 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef EVENT_BINNING_H
+#define EVENT_BINNING_H
+
+#include <algorithm>
+#include <vector>
+
+#include <gsl/gsl_util>
+
+#include "dataset.h"
+#include "variable.h"
+
+/// Maps event coordinates to the bins given by a 1-dimensional bin-edge
+/// variable. Bins of progressions are found in closed form, other edges by
+/// binary search.
+class EventBinning {
+public:
+  explicit EventBinning(const Variable &edges);
+
+  /// Returns the number of bins.
+  gsl::index size() const { return m_bins; }
+  /// Returns the edge `i`, i.e., the lower bound of bin `i`.
+  double edge(const gsl::index i) const {
+    return m_isProgression ? m_progression[i] : m_edges[i];
+  }
+  /// Returns the bin containing `x`, or -1 if `x` is outside the edges.
+  gsl::index operator()(const double x) const {
+    gsl::index bin;
+    if (m_isProgression)
+      bin = m_progression.lowerIndex(x);
+    else
+      bin = std::upper_bound(m_edges.begin(), m_edges.end(), x) -
+            m_edges.begin() - 1;
+    return bin >= 0 && bin < m_bins ? bin : -1;
+  }
+
+private:
+  bool m_isProgression;
+  Progression m_progression;
+  std::vector<double> m_edges;
+  gsl::index m_bins;
+};
+
+/// Returns the dimensions of a histogram with the given bin edges. The
+/// dimension of the first edges becomes the outermost dimension.
+Dimensions binnedDimensions(const std::vector<Variable> &edges);
+/// Returns a dataset with the bin edges as coordinates and the sum of the
+/// per-thread histograms `tiles` as Data::Value. Empty tiles are skipped.
+Dataset makeHistogram(const std::vector<Variable> &edges,
+                      const Dimensions &dims,
+                      const std::vector<std::vector<double>> &tiles);
+
+#endif // EVENT_BINNING_H
@@ -0,0 +1,295 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <cmath>
+#include <limits>
+
+#include <omp.h>
+
+#include "event_binning.h"
+#include "event_box_tree.h"
+
+EventBoxTree::EventBoxTree(const std::vector<Dim> &dims,
+                           const std::vector<gsl::span<const double>> &columns,
+                           const gsl::index splitThreshold,
+                           const gsl::index maxDepth)
+    : m_dims(dims), m_size(columns.empty() ? 0 : columns.front().size()) {
+  const gsl::index ndim = dims.size();
+  if (ndim == 0 || ndim > 8)
+    throw std::runtime_error(
+        "EventBoxTree: Number of dimensions must be between 1 and 8.");
+  if (columns.size() != dims.size())
+    throw std::runtime_error(
+        "EventBoxTree: Require one column of coordinates per dimension.");
+  for (const auto &column : columns)
+    if (column.size() != m_size)
+      throw std::runtime_error(
+          "EventBoxTree: All columns must have the same length.");
+  if (splitThreshold < 1)
+    throw std::runtime_error("EventBoxTree: Split threshold must be positive.");
+
+  // Events with a NaN or infinite coordinate lie outside of any box and
+  // cannot be found by count() or bin(), they are not stored.
+  std::vector<gsl::index> finite;
+  for (gsl::index i = 0; i < m_size; ++i) {
+    bool isFinite = true;
+    for (const auto &column : columns)
+      isFinite &= std::isfinite(column[i]);
+    if (isFinite)
+      finite.push_back(i);
+  }
+  const bool dropped = static_cast<gsl::index>(finite.size()) != m_size;
+  m_size = finite.size();
+
+  m_coords.resize(ndim * m_size);
+  m_bounds.resize(2 * ndim);
+  for (gsl::index dim = 0; dim < ndim; ++dim) {
+    const auto *in = columns[dim].data();
+    auto *out = m_coords.data() + dim * m_size;
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+#pragma omp parallel for reduction(min : lo) reduction(max : hi)
+    for (gsl::index i = 0; i < m_size; ++i) {
+      out[i] = in[dropped ? finite[i] : i];
+      lo = std::min(lo, out[i]);
+      hi = std::max(hi, out[i]);
+    }
+    if (m_size == 0)
+      lo = hi = 0.0;
+    // Boxes are half-open, widen the root box to include the largest value.
+    m_bounds[dim] = lo;
+    m_bounds[ndim + dim] =
+        std::nextafter(hi, std::numeric_limits<double>::infinity());
+  }
+  m_boxes.push_back({0, m_size, -1});
+
+  // The tree is built level by level. Few large boxes are split one after the
+  // other with parallel loops over their events, many small boxes are split
+  // in parallel with one box per thread.
+  const gsl::index childCount = gsl::index{1} << ndim;
+  std::vector<double> scratch(m_coords.size());
+  std::vector<int32_t> children(m_size);
+  std::vector<gsl::index> frontier;
+  if (m_size > splitThreshold)
+    frontier.push_back(0);
+  for (gsl::index depth = 0; depth < maxDepth && !frontier.empty(); ++depth) {
+    std::vector<gsl::index> counts(frontier.size() * childCount, 0);
+    const gsl::index boxes = frontier.size();
+    const bool perBox = boxes >= omp_get_max_threads();
+#pragma omp parallel for schedule(dynamic) if (perBox)
+    for (gsl::index i = 0; i < boxes; ++i)
+      split(frontier[i], counts.data() + i * childCount, !perBox, scratch,
+            children);
+
+    std::vector<gsl::index> next;
+    for (gsl::index i = 0; i < boxes; ++i) {
+      const auto parent = frontier[i];
+      m_boxes[parent].firstChild = m_boxes.size();
+      auto begin = m_boxes[parent].begin;
+      for (gsl::index child = 0; child < childCount; ++child) {
+        const auto end = begin + counts[i * childCount + child];
+        if (end - begin > splitThreshold)
+          next.push_back(m_boxes.size());
+        m_boxes.push_back({begin, end, -1});
+        const auto bounds = m_bounds.size();
+        m_bounds.resize(bounds + 2 * ndim);
+        for (gsl::index dim = 0; dim < ndim; ++dim) {
+          const double lo = lower(parent)[dim];
+          const double hi = upper(parent)[dim];
+          // Does not overflow for bounds close to the largest double.
+          const double mid = 0.5 * lo + 0.5 * hi;
+          const bool upperHalf = child & (gsl::index{1} << dim);
+          m_bounds[bounds + dim] = upperHalf ? mid : lo;
+          m_bounds[bounds + ndim + dim] = upperHalf ? hi : mid;
+        }
+        begin = end;
+      }
+    }
+    frontier = std::move(next);
+  }
+}
+
+/// Reorders the events of `box` such that the events of each child are
+/// contiguous and stores the number of events per child in `counts`.
+void EventBoxTree::split(const gsl::index box, gsl::index *counts,
+                         const bool parallel, std::vector<double> &scratch,
+                         std::vector<int32_t> &children) {
+  const gsl::index ndim = m_dims.size();
+  const auto begin = m_boxes[box].begin;
+  const auto end = m_boxes[box].end;
+  std::vector<double> mid(ndim);
+  for (gsl::index dim = 0; dim < ndim; ++dim)
+    mid[dim] = 0.5 * lower(box)[dim] + 0.5 * upper(box)[dim];
+
+#pragma omp parallel for if (parallel)
+  for (gsl::index i = begin; i < end; ++i) {
+    int32_t child = 0;
+    for (gsl::index dim = 0; dim < ndim; ++dim)
+      if (coord(dim, i) >= mid[dim])
+        child |= 1 << dim;
+    children[i] = child;
+  }
+  for (gsl::index i = begin; i < end; ++i)
+    ++counts[children[i]];
+
+  std::vector<gsl::index> position(gsl::index{1} << ndim);
+  auto offset = begin;
+  for (gsl::index child = 0; child < gsl::index{1} << ndim; ++child) {
+    position[child] = offset;
+    offset += counts[child];
+  }
+  for (gsl::index i = begin; i < end; ++i) {
+    const auto target = position[children[i]]++;
+    for (gsl::index dim = 0; dim < ndim; ++dim)
+      scratch[dim * m_size + target] = coord(dim, i);
+  }
+  for (gsl::index dim = 0; dim < ndim; ++dim)
+    std::copy(scratch.begin() + dim * m_size + begin,
+              scratch.begin() + dim * m_size + end,
+              m_coords.begin() + dim * m_size + begin);
+}
+
+gsl::index EventBoxTree::count(
+    const std::vector<std::pair<double, double>> &region) const {
+  const gsl::index ndim = m_dims.size();
+  if (region.size() != m_dims.size())
+    throw std::runtime_error(
+        "EventBoxTree: Region must have one range per dimension.");
+  gsl::index total = 0;
+  std::vector<gsl::index> stack{0};
+  while (!stack.empty()) {
+    const auto box = stack.back();
+    stack.pop_back();
+    bool disjoint = false;
+    bool contained = true;
+    for (gsl::index dim = 0; dim < ndim; ++dim) {
+      const auto &range = region[dim];
+      if (upper(box)[dim] <= range.first || lower(box)[dim] >= range.second)
+        disjoint = true;
+      if (lower(box)[dim] < range.first || upper(box)[dim] > range.second)
+        contained = false;
+    }
+    if (disjoint)
+      continue;
+    const auto &b = m_boxes[box];
+    if (contained) {
+      total += b.end - b.begin;
+    } else if (b.firstChild < 0) {
+      for (gsl::index i = b.begin; i < b.end; ++i) {
+        bool inside = true;
+        for (gsl::index dim = 0; dim < ndim; ++dim)
+          inside &= coord(dim, i) >= region[dim].first &&
+                    coord(dim, i) < region[dim].second;
+        total += inside;
+      }
+    } else {
+      for (gsl::index child = 0; child < gsl::index{1} << ndim; ++child)
+        stack.push_back(b.firstChild + child);
+    }
+  }
+  return total;
+}
+
+Dataset EventBoxTree::bin(const std::vector<Variable> &edges) const {
+  if (edges.empty())
+    throw std::runtime_error("EventBoxTree: Require at least one dimension "
+                             "with bin edges.");
+  std::vector<EventBinning> binnings;
+  std::vector<gsl::index> axes;
+  for (const auto &var : edges) {
+    binnings.emplace_back(var);
+    const auto dim = var.dimensions().labels()[0];
+    const auto it = std::find(m_dims.begin(), m_dims.end(), dim);
+    if (it == m_dims.end())
+      throw std::runtime_error(
+          "EventBoxTree: Bin edges must be along a dimension of the tree.");
+    axes.push_back(it - m_dims.begin());
+  }
+  const auto dims = binnedDimensions(edges);
+  std::vector<gsl::index> strides;
+  for (const auto &var : edges)
+    strides.push_back(dims.offset(var.dimensions().labels()[0]));
+  const gsl::index childCount = gsl::index{1} << m_dims.size();
+
+  // Expand the top of the tree until there are enough boxes to balance the
+  // load of the threads.
+  const gsl::index minBoxes = 16 * omp_get_max_threads();
+  std::vector<gsl::index> boxes{0};
+  bool expanded = true;
+  while (expanded && static_cast<gsl::index>(boxes.size()) < minBoxes) {
+    expanded = false;
+    std::vector<gsl::index> next;
+    for (const auto box : boxes) {
+      if (m_boxes[box].firstChild < 0) {
+        next.push_back(box);
+        continue;
+      }
+      for (gsl::index child = 0; child < childCount; ++child)
+        next.push_back(m_boxes[box].firstChild + child);
+      expanded = true;
+    }
+    boxes = std::move(next);
+  }
+
+  const gsl::index count = boxes.size();
+  std::vector<std::vector<double>> tiles(omp_get_max_threads());
+#pragma omp parallel
+  {
+    auto &tile = tiles[omp_get_thread_num()];
+    tile.resize(dims.volume());
+    std::vector<gsl::index> stack;
+#pragma omp for schedule(dynamic)
+    for (gsl::index i = 0; i < count; ++i) {
+      stack.push_back(boxes[i]);
+      while (!stack.empty()) {
+        const auto box = stack.back();
+        stack.pop_back();
+        const auto &b = m_boxes[box];
+        // A box that lies within a single bin in all binned dimensions is
+        // added as a whole.
+        bool disjoint = false;
+        bool single = true;
+        gsl::index offset = 0;
+        for (size_t j = 0; j < binnings.size(); ++j) {
+          const auto &binning = binnings[j];
+          const double lo = lower(box)[axes[j]];
+          const double hi = upper(box)[axes[j]];
+          if (hi <= binning.edge(0) || lo >= binning.edge(binning.size())) {
+            disjoint = true;
+            break;
+          }
+          const auto bin = binning(lo);
+          if (bin < 0 || hi > binning.edge(bin + 1))
+            single = false;
+          else
+            offset += bin * strides[j];
+        }
+        if (disjoint || b.begin == b.end)
+          continue;
+        if (single) {
+          tile[offset] += b.end - b.begin;
+        } else if (b.firstChild < 0) {
+          for (gsl::index event = b.begin; event < b.end; ++event) {
+            gsl::index eventOffset = 0;
+            for (size_t j = 0; j < binnings.size(); ++j) {
+              const auto bin = binnings[j](coord(axes[j], event));
+              if (bin < 0) {
+                eventOffset = -1;
+                break;
+              }
+              eventOffset += bin * strides[j];
+            }
+            if (eventOffset >= 0)
+              tile[eventOffset] += 1.0;
+          }
+        } else {
+          for (gsl::index child = 0; child < childCount; ++child)
+            stack.push_back(b.firstChild + child);
+        }
+      }
+    }
+  }
+  return makeHistogram(edges, dims, tiles);
+}
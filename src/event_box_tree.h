@@ -0,0 +1,82 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef EVENT_BOX_TREE_H
+#define EVENT_BOX_TREE_H
+
+#include <utility>
+#include <vector>
+
+#include <gsl/gsl_util>
+#include <gsl/span>
+
+#include "dataset.h"
+#include "dimension.h"
+
+/// Adaptive tree of boxes over events with coordinates in several dimensions,
+/// e.g., in Q-space.
+///
+/// Boxes with more than a threshold number of events are split into halves
+/// along every dimension, i.e., into 2^N children for N dimensions, such that
+/// densely populated regions are resolved finely while sparse regions cost
+/// little memory. Every box knows its event count, so counts in regions and
+/// histograms are computed from the boxes and only events in boxes that are
+/// cut by a region boundary or bin edge are inspected individually.
+class EventBoxTree {
+public:
+  /// Builds the tree from one column of event coordinates for each of `dims`.
+  /// Boxes with more than `splitThreshold` events are split, up to a depth of
+  /// `maxDepth` levels below the root box. Events with a NaN or infinite
+  /// coordinate are not stored.
+  EventBoxTree(const std::vector<Dim> &dims,
+               const std::vector<gsl::span<const double>> &columns,
+               const gsl::index splitThreshold = 1024,
+               const gsl::index maxDepth = 16);
+
+  const std::vector<Dim> &dimensions() const { return m_dims; }
+  /// Returns the number of stored events, i.e., with finite coordinates.
+  gsl::index size() const { return m_size; }
+  /// Returns the number of boxes, including the root and all inner boxes.
+  gsl::index boxCount() const { return m_boxes.size(); }
+
+  /// Returns the number of events in the region [lo, hi) given as one pair
+  /// per dimension, in the order of `dimensions()`.
+  gsl::index count(const std::vector<std::pair<double, double>> &region) const;
+  /// Histogram of the events as returned by binEvents, for 1-dimensional bin
+  /// edges along a subset of the dimensions of the tree. Dimensions without
+  /// bin edges are summed over.
+  Dataset bin(const std::vector<Variable> &edges) const;
+
+private:
+  struct Box {
+    gsl::index begin;
+    gsl::index end;
+    gsl::index firstChild;
+  };
+
+  const double *lower(const gsl::index box) const {
+    return m_bounds.data() + 2 * m_dims.size() * box;
+  }
+  const double *upper(const gsl::index box) const {
+    return lower(box) + m_dims.size();
+  }
+  double coord(const gsl::index dim, const gsl::index event) const {
+    return m_coords[dim * m_size + event];
+  }
+  void split(const gsl::index box, gsl::index *counts, const bool parallel,
+             std::vector<double> &scratch,
+             std::vector<int32_t> &children);
+
+  std::vector<Dim> m_dims;
+  gsl::index m_size;
+  /// Event coordinates, one column per dimension, ordered such that the events
+  /// of every box are the contiguous range [begin, end).
+  std::vector<double> m_coords;
+  std::vector<Box> m_boxes;
+  /// Lower and upper bounds of every box, the boxes are half-open.
+  std::vector<double> m_bounds;
+};
+
+#endif // EVENT_BOX_TREE_H
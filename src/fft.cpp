@@ -0,0 +1,183 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "except.h"
+#include "fft.h"
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+} // namespace
+
+FFTPlan::FFTPlan(const gsl::index size) : m_size(size) {
+  if (size < 1)
+    throw std::runtime_error("FFT size must be positive.");
+  const bool isPowerOfTwo = (size & (size - 1)) == 0;
+  m_radixSize = detail::fftSize(isPowerOfTwo ? size : 2 * size - 1);
+  m_twiddles.resize(m_radixSize / 2);
+  for (gsl::index i = 0; i < m_radixSize / 2; ++i)
+    m_twiddles[i] = std::polar(1.0, -2.0 * pi * i / m_radixSize);
+  if (isPowerOfTwo)
+    return;
+  // Bluestein: X_k = c_k * sum_n (x_n * c_n) * conj(c_{k-n}) with the chirp
+  // c_n = exp(-i pi n^2 / N). The sum is a convolution, computed via FFT of
+  // length m_radixSize >= 2N - 1.
+  m_chirp.resize(size);
+  for (gsl::index i = 0; i < size; ++i) {
+    // Reduce n^2 modulo 2N to preserve precision for large n.
+    const gsl::index n2 = (i * i) % (2 * size);
+    m_chirp[i] = std::polar(1.0, -pi * n2 / size);
+  }
+  m_chirpTransform.resize(m_radixSize);
+  m_chirpTransform[0] = std::conj(m_chirp[0]);
+  for (gsl::index i = 1; i < size; ++i)
+    m_chirpTransform[i] = m_chirpTransform[m_radixSize - i] =
+        std::conj(m_chirp[i]);
+  radix2(m_chirpTransform.data(), false);
+}
+
+std::shared_ptr<const FFTPlan> FFTPlan::get(const gsl::index size) {
+  static std::mutex mutex;
+  static std::map<gsl::index, std::shared_ptr<const FFTPlan>> plans;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &plan = plans[size];
+  if (!plan)
+    plan = std::make_shared<const FFTPlan>(size);
+  return plan;
+}
+
+void FFTPlan::radix2(std::complex<double> *data, const bool inverse) const {
+  const gsl::index size = m_radixSize;
+  // Bit-reversal permutation.
+  for (gsl::index i = 1, j = 0; i < size; ++i) {
+    gsl::index bit = size >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(data[i], data[j]);
+  }
+  // Iterative Cooley-Tukey butterflies.
+  for (gsl::index length = 2; length <= size; length <<= 1) {
+    const gsl::index half = length / 2;
+    const gsl::index step = size / length;
+    for (gsl::index i = 0; i < size; i += length) {
+      for (gsl::index j = 0; j < half; ++j) {
+        const auto w = inverse ? std::conj(m_twiddles[j * step])
+                               : m_twiddles[j * step];
+        const auto u = data[i + j];
+        const auto v = data[i + j + half] * w;
+        data[i + j] = u + v;
+        data[i + j + half] = u - v;
+      }
+    }
+  }
+}
+
+void FFTPlan::transform(std::complex<double> *data, const bool inverse) const {
+  if (m_chirp.empty())
+    return radix2(data, inverse);
+  // The inverse transform is obtained as conj(fft(conj(x))).
+  thread_local std::vector<std::complex<double>> work;
+  work.assign(m_radixSize, 0.0);
+  for (gsl::index i = 0; i < m_size; ++i)
+    work[i] = (inverse ? std::conj(data[i]) : data[i]) * m_chirp[i];
+  radix2(work.data(), false);
+  for (gsl::index i = 0; i < m_radixSize; ++i)
+    work[i] *= m_chirpTransform[i];
+  radix2(work.data(), true);
+  const double scale = 1.0 / m_radixSize;
+  for (gsl::index i = 0; i < m_size; ++i) {
+    const auto x = work[i] * m_chirp[i] * scale;
+    data[i] = inverse ? std::conj(x) : x;
+  }
+}
+
+namespace {
+Variable transform(const Variable &var, const Dim dim, const bool inverse) {
+  const auto &dims = var.dimensions();
+  if (!dims.contains(dim))
+    throw dataset::except::DimensionNotFoundError(dims, dim);
+  auto out = makeVariable<Data::Complex>(dims);
+  if (var.isData())
+    out.setName(var.name());
+  out.setUnit(var.unit());
+  auto result = out.get<Data::Complex>();
+  // Constant data has no raw values, read from a temporary dense copy.
+  const auto dense = var.isConstant() ? toDense(var) : var;
+  if (var.valueTypeIs<Data::Value>() && !inverse) {
+    const auto in = dense.get<const Data::Value>();
+    std::copy(in.begin(), in.end(), result.begin());
+  } else if (var.valueTypeIs<Data::Complex>()) {
+    const auto in = dense.get<const Data::Complex>();
+    std::copy(in.begin(), in.end(), result.begin());
+  } else {
+    throw std::runtime_error(inverse ? "Cannot compute inverse FFT: Input "
+                                       "must be Data::Complex."
+                                     : "Cannot compute FFT: Input must be "
+                                       "Data::Value or Data::Complex.");
+  }
+
+  const gsl::index size = dims.size(dim);
+  if (size == 0)
+    return out;
+  const gsl::index inner = dims.offset(dim);
+  const gsl::index count = dims.volume() / size;
+  const auto plan = FFTPlan::get(size);
+  const double scale = inverse ? 1.0 / size : 1.0;
+  auto *data = result.data();
+  // Batched over all lines along `dim`. Contiguous lines are transformed in
+  // place, strided lines are gathered into a per-thread buffer, i.e., there is
+  // no need to transpose the data.
+#pragma omp parallel
+  {
+    std::vector<std::complex<double>> buffer(inner == 1 ? 0 : size);
+#pragma omp for
+    for (gsl::index line = 0; line < count; ++line) {
+      auto *begin = data + (line / inner) * size * inner + line % inner;
+      if (inner == 1) {
+        plan->transform(begin, inverse);
+        if (inverse)
+          for (gsl::index i = 0; i < size; ++i)
+            begin[i] *= scale;
+      } else {
+        for (gsl::index i = 0; i < size; ++i)
+          buffer[i] = begin[i * inner];
+        plan->transform(buffer.data(), inverse);
+        for (gsl::index i = 0; i < size; ++i)
+          begin[i * inner] = buffer[i] * scale;
+      }
+    }
+  }
+  return out;
+}
+} // namespace
+
+Variable fft(const Variable &var, const Dim dim) {
+  return transform(var, dim, false);
+}
+
+Variable ifft(const Variable &var, const Dim dim) {
+  return transform(var, dim, true);
+}
+
+namespace detail {
+void fft(std::complex<double> *data, const gsl::index size,
+         const bool inverse) {
+  FFTPlan::get(size)->transform(data, inverse);
+}
+
+gsl::index fftSize(const gsl::index size) {
+  gsl::index n = 1;
+  while (n < size)
+    n <<= 1;
+  return n;
+}
+} // namespace detail
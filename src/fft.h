@@ -0,0 +1,64 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+#include <gsl/gsl_util>
+
+#include "dimension.h"
+#include "variable.h"
+
+/// Precomputed data for discrete Fourier transforms of a given length.
+///
+/// Power-of-two lengths use an iterative radix-2 transform with precomputed
+/// twiddle factors. Other lengths are mapped to a power-of-two convolution
+/// using Bluestein's algorithm, so the cost is O(n log n) for any n. Plans are
+/// immutable and can be shared between threads, use `FFTPlan::get` to obtain
+/// a cached plan.
+class FFTPlan {
+public:
+  explicit FFTPlan(const gsl::index size);
+
+  /// Returns the cached plan for the given length, creating it if required.
+  static std::shared_ptr<const FFTPlan> get(const gsl::index size);
+
+  gsl::index size() const { return m_size; }
+
+  /// In-place transform of `size()` elements. The inverse transform is not
+  /// normalized.
+  void transform(std::complex<double> *data, const bool inverse) const;
+
+private:
+  void radix2(std::complex<double> *data, const bool inverse) const;
+
+  gsl::index m_size;
+  gsl::index m_radixSize;
+  std::vector<std::complex<double>> m_twiddles;
+  // Only used for non-power-of-two sizes.
+  std::vector<std::complex<double>> m_chirp;
+  std::vector<std::complex<double>> m_chirpTransform;
+};
+
+/// Discrete Fourier transform along `dim`. The input must be Data::Value or
+/// Data::Complex, the result is Data::Complex.
+Variable fft(const Variable &var, const Dim dim);
+/// Inverse of `fft`, including normalization by the length of `dim`.
+Variable ifft(const Variable &var, const Dim dim);
+
+namespace detail {
+/// In-place FFT of `size` elements using a cached plan. The inverse transform
+/// is not normalized.
+void fft(std::complex<double> *data, const gsl::index size,
+         const bool inverse = false);
+/// Returns the smallest power of two that is not smaller than `size`.
+gsl::index fftSize(const gsl::index size);
+} // namespace detail
+
+#endif // FFT_H
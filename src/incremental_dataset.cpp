@@ -0,0 +1,82 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <algorithm>
+
+#include "except.h"
+#include "incremental_dataset.h"
+
+IncrementalDataset::IncrementalDataset(Dataset source, const Dim dim)
+    : m_source(std::move(source)), m_dim(dim) {
+  if (!m_source.dimensions().contains(dim))
+    throw dataset::except::DimensionNotFoundError(m_source.dimensions(), dim);
+}
+
+Slice<Dataset> IncrementalDataset::slice(const gsl::index begin,
+                                         const gsl::index end) {
+  if (begin < 0 || end > m_source.dimensions()[m_dim] || begin >= end)
+    throw std::runtime_error("IncrementalDataset: Invalid range.");
+  markModified(begin, end);
+  return m_source(m_dim, begin, end);
+}
+
+void IncrementalDataset::setSlice(const Dataset &slice,
+                                  const gsl::index index) {
+  m_source.setSlice(slice, m_dim, index);
+  markModified(index, index + 1);
+}
+
+gsl::index IncrementalDataset::addDerived(Operation operation) {
+  auto result = operation(m_source);
+  if (!result.dimensions().contains(m_dim) ||
+      result.dimensions()[m_dim] != m_source.dimensions()[m_dim])
+    throw std::runtime_error("IncrementalDataset: Derived dataset must have "
+                             "the same extent as the source along the "
+                             "tracked dimension.");
+  m_derived.push_back({std::move(operation), std::move(result), {}});
+  return m_derived.size() - 1;
+}
+
+const Dataset &IncrementalDataset::derived(const gsl::index i) {
+  auto &derived = m_derived.at(i);
+  auto &modified = derived.modified;
+  // Merge overlapping and adjacent ranges such that every slice is computed
+  // at most once and the operation is called as few times as possible.
+  std::sort(modified.begin(), modified.end());
+  std::vector<std::pair<gsl::index, gsl::index>> ranges;
+  for (const auto &range : modified)
+    if (!ranges.empty() && range.first <= ranges.back().second)
+      ranges.back().second = std::max(ranges.back().second, range.second);
+    else
+      ranges.push_back(range);
+  // A range is removed only once it has been recomputed, such that ranges
+  // are recomputed by the next call if the operation throws. Stored in
+  // reverse, ranges are processed in ascending order.
+  modified.assign(ranges.rbegin(), ranges.rend());
+
+  auto result = detail::makeAccess(derived.result);
+  while (!modified.empty()) {
+    const auto range = modified.back();
+    const auto update = derived.operation(
+        Dataset(source()(m_dim, range.first, range.second)));
+    for (gsl::index j = 0; j < derived.result.size(); ++j) {
+      auto &var = result[j];
+      // Variables without the tracked dimension, e.g., coordinates, do not
+      // depend on individual slices of the source.
+      if (!var.dimensions().contains(m_dim))
+        continue;
+      var(m_dim, range.first, range.second)
+          .copyFrom(update[update.find(var.type(), var.name())]);
+    }
+    modified.pop_back();
+  }
+  return derived.result;
+}
+
+void IncrementalDataset::markModified(const gsl::index begin,
+                                      const gsl::index end) {
+  for (auto &derived : m_derived)
+    derived.modified.emplace_back(begin, end);
+}
@@ -0,0 +1,61 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef INCREMENTAL_DATASET_H
+#define INCREMENTAL_DATASET_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <gsl/gsl_util>
+
+#include "dataset.h"
+
+/// A source dataset with derived datasets, e.g., rebinned or normalized, that
+/// are updated incrementally when slices of the source change.
+///
+/// Writes to the source go through `slice` or `setSlice`, which record the
+/// modified range along the tracked dimension, typically Dim::Spectrum. When
+/// a derived dataset is requested, its operation is applied only to the
+/// modified ranges of the source and the results are copied into the
+/// corresponding slices of the derived dataset. Operations must therefore act
+/// independently on each slice along the tracked dimension.
+class IncrementalDataset {
+public:
+  using Operation = std::function<Dataset(const Dataset &)>;
+
+  IncrementalDataset(Dataset source, const Dim dim);
+
+  const Dataset &source() const { return m_source; }
+  /// Returns the slices [begin, end) of the source for writing and marks them
+  /// as modified. Writes through the returned slice after the next call to
+  /// `derived` are not tracked, call `slice` again for further writes.
+  Slice<Dataset> slice(const gsl::index begin, const gsl::index end);
+  /// Sets slice `index` of the source and marks it as modified.
+  void setSlice(const Dataset &slice, const gsl::index index);
+
+  /// Registers a derived dataset given by `operation` applied to the source
+  /// and returns its index.
+  gsl::index addDerived(Operation operation);
+  /// Returns derived dataset `i`, after recomputing its modified slices. If
+  /// the operation throws, slices that were not recomputed stay modified.
+  const Dataset &derived(const gsl::index i);
+
+private:
+  struct Derived {
+    Operation operation;
+    Dataset result;
+    std::vector<std::pair<gsl::index, gsl::index>> modified;
+  };
+
+  void markModified(const gsl::index begin, const gsl::index end);
+
+  Dataset m_source;
+  Dim m_dim;
+  std::vector<Derived> m_derived;
+};
+
+#endif // INCREMENTAL_DATASET_H
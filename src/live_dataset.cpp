@@ -0,0 +1,32 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <atomic>
+
+#include "live_dataset.h"
+
+LiveDataset::LiveDataset() : LiveDataset(Dataset{}) {}
+
+LiveDataset::LiveDataset(Dataset d)
+    : m_latest(std::make_shared<const Dataset>(std::move(d))) {}
+
+LiveDataset::Snapshot LiveDataset::snapshot() const {
+  return std::atomic_load(&m_latest);
+}
+
+void LiveDataset::update(const std::function<void(Dataset &)> &update) {
+  std::lock_guard<std::mutex> lock(m_writer);
+  // Only writers replace m_latest, so it can be read without atomic_load
+  // while holding the lock.
+  auto next = std::make_shared<Dataset>(*m_latest);
+  update(*next);
+  std::atomic_store(&m_latest, Snapshot(std::move(next)));
+}
+
+void LiveDataset::publish(Dataset d) {
+  std::lock_guard<std::mutex> lock(m_writer);
+  std::atomic_store(&m_latest,
+                    Snapshot(std::make_shared<const Dataset>(std::move(d))));
+}
@@ -0,0 +1,45 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef LIVE_DATASET_H
+#define LIVE_DATASET_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "dataset.h"
+
+/// Versions of a dataset that is updated while it is being read, e.g., by
+/// live reduction and a viewer running on different threads.
+///
+/// Readers obtain the latest published version as an immutable snapshot,
+/// writers build the next version from a copy and publish it atomically.
+/// Since variables are copy-on-write, the copy shares all data with the
+/// previous version and only variables modified by the writer are copied.
+/// Readers never wait for writers and a version is released when its last
+/// snapshot is destroyed. Writers are serialized among each other.
+class LiveDataset {
+public:
+  using Snapshot = std::shared_ptr<const Dataset>;
+
+  LiveDataset();
+  explicit LiveDataset(Dataset d);
+
+  /// Returns the latest published version. The snapshot does not change when
+  /// further versions are published.
+  Snapshot snapshot() const;
+  /// Applies `update` to a copy of the latest version and publishes the
+  /// result. Nothing is published if `update` throws.
+  void update(const std::function<void(Dataset &)> &update);
+  /// Publishes `d` as the latest version.
+  void publish(Dataset d);
+
+private:
+  std::mutex m_writer;
+  Snapshot m_latest;
+};
+
+#endif // LIVE_DATASET_H
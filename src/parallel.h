@@ -0,0 +1,41 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <exception>
+
+#include <gsl/gsl_util>
+
+namespace detail {
+/// Calls `f(i)` in parallel for all `i` in [0, size). If `f` throws, the
+/// exception of the lowest failed index is rethrown once all threads are done.
+/// Indices above the lowest failed index seen so far are skipped, indices
+/// below it are still processed since they may fail as well.
+template <class F> void parallelFor(const gsl::index size, F f) {
+  std::atomic<gsl::index> exceptionIndex{size};
+  std::exception_ptr exception;
+#pragma omp parallel for schedule(guided)
+  for (gsl::index i = 0; i < size; ++i) {
+    if (i > exceptionIndex.load(std::memory_order_relaxed))
+      continue;
+    try {
+      f(i);
+    } catch (...) {
+#pragma omp critical(parallelFor)
+      if (i < exceptionIndex) {
+        exceptionIndex = i;
+        exception = std::current_exception();
+      }
+    }
+  }
+  if (exception)
+    std::rethrow_exception(exception);
+}
+} // namespace detail
+
+#endif // PARALLEL_H
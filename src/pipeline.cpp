@@ -0,0 +1,176 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "pipeline.h"
+
+namespace {
+struct Chunk {
+  gsl::index begin;
+  gsl::index end;
+  Dataset data;
+};
+
+/// Queue between two stages. Consumers see the end of the stream once all
+/// producers are done and the queue is drained, or once it is aborted.
+class BoundedQueue {
+public:
+  BoundedQueue(const gsl::index capacity, const gsl::index producers)
+      : m_capacity(capacity), m_producers(producers) {}
+
+  /// Blocks while the queue is full. Returns false if the queue was aborted.
+  bool push(Chunk chunk) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] {
+      return m_aborted || gsl::index(m_chunks.size()) < m_capacity;
+    });
+    if (m_aborted)
+      return false;
+    m_chunks.push_back(std::move(chunk));
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  std::optional<Chunk> pop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this] {
+      return m_aborted || !m_chunks.empty() || m_producers == 0;
+    });
+    if (m_aborted || m_chunks.empty())
+      return std::nullopt;
+    auto chunk = std::move(m_chunks.front());
+    m_chunks.pop_front();
+    m_notFull.notify_one();
+    return chunk;
+  }
+
+  void done() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_producers == 0)
+      m_notEmpty.notify_all();
+  }
+
+  void abort() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_aborted = true;
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+  }
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_notFull;
+  std::condition_variable m_notEmpty;
+  std::deque<Chunk> m_chunks;
+  const gsl::index m_capacity;
+  gsl::index m_producers;
+  bool m_aborted{false};
+};
+} // namespace
+
+Pipeline::Pipeline(const gsl::index size, Reader reader, Writer writer)
+    : m_size(size), m_reader(std::move(reader)), m_writer(std::move(writer)) {
+  if (m_size < 0)
+    throw std::runtime_error("Pipeline: Size must not be negative.");
+}
+
+Pipeline &Pipeline::addStage(Stage stage, const gsl::index threads) {
+  if (threads < 1)
+    throw std::runtime_error("Pipeline: A stage requires at least one thread.");
+  m_stages.push_back({std::move(stage), threads});
+  return *this;
+}
+
+Pipeline &Pipeline::setChunkSize(const gsl::index chunkSize) {
+  if (chunkSize < 1)
+    throw std::runtime_error("Pipeline: Chunk size must be positive.");
+  m_chunkSize = chunkSize;
+  return *this;
+}
+
+Pipeline &Pipeline::setQueueCapacity(const gsl::index capacity) {
+  if (capacity < 1)
+    throw std::runtime_error("Pipeline: Queue capacity must be positive.");
+  m_queueCapacity = capacity;
+  return *this;
+}
+
+void Pipeline::run() const {
+  // Queue i feeds compute stage i, the last queue feeds the writer.
+  std::vector<std::unique_ptr<BoundedQueue>> queues;
+  queues.push_back(std::make_unique<BoundedQueue>(m_queueCapacity, 1));
+  for (const auto &stage : m_stages)
+    queues.push_back(
+        std::make_unique<BoundedQueue>(m_queueCapacity, stage.threads));
+
+  std::mutex errorMutex;
+  std::exception_ptr error;
+  const auto fail = [&]() {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (!error)
+      error = std::current_exception();
+    for (auto &queue : queues)
+      queue->abort();
+  };
+
+  std::vector<std::thread> threads;
+  // If starting a thread fails, the threads started so far must be stopped
+  // and joined, destroying a joinable std::thread calls std::terminate.
+  try {
+    threads.emplace_back([&]() {
+      try {
+        for (gsl::index begin = 0; begin < m_size; begin += m_chunkSize) {
+          const auto end = std::min(begin + m_chunkSize, m_size);
+          if (!queues.front()->push({begin, end, m_reader(begin, end)}))
+            break;
+        }
+      } catch (...) {
+        fail();
+      }
+      queues.front()->done();
+    });
+    for (gsl::index i = 0; i < static_cast<gsl::index>(m_stages.size()); ++i) {
+      for (gsl::index thread = 0; thread < m_stages[i].threads; ++thread) {
+        threads.emplace_back([&, i]() {
+          auto &in = *queues[i];
+          auto &out = *queues[i + 1];
+          try {
+            while (auto chunk = in.pop()) {
+              chunk->data = m_stages[i].function(std::move(chunk->data));
+              if (!out.push(std::move(*chunk)))
+                break;
+            }
+          } catch (...) {
+            fail();
+          }
+          out.done();
+        });
+      }
+    }
+  } catch (...) {
+    for (auto &queue : queues)
+      queue->abort();
+    for (auto &thread : threads)
+      thread.join();
+    throw;
+  }
+
+  try {
+    while (auto chunk = queues.back()->pop())
+      m_writer(chunk->begin, chunk->end, std::move(chunk->data));
+  } catch (...) {
+    fail();
+  }
+  for (auto &thread : threads)
+    thread.join();
+  if (error)
+    std::rethrow_exception(error);
+}
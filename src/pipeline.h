@@ -0,0 +1,61 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <functional>
+#include <vector>
+
+#include <gsl/gsl_util>
+
+#include "dataset.h"
+
+/// Chunked processing of a range [0, size), e.g., of spectra in a file, with
+/// reading, computing and writing overlapped.
+///
+/// The reader stage produces one dataset per chunk [begin, end), each compute
+/// stage transforms it, and the writer stage consumes it. Every stage runs on
+/// its own threads, chunks are passed on via bounded queues. A full queue
+/// blocks the upstream stage, i.e., the queue capacity bounds the number of
+/// chunks in memory. Compute stages with more than one thread, as well as the
+/// writer, may see chunks out of order.
+///
+/// The first exception thrown by any stage stops the pipeline and is rethrown
+/// by run().
+class Pipeline {
+public:
+  using Reader =
+      std::function<Dataset(const gsl::index begin, const gsl::index end)>;
+  using Stage = std::function<Dataset(Dataset)>;
+  using Writer = std::function<void(const gsl::index begin,
+                                    const gsl::index end, Dataset)>;
+
+  Pipeline(const gsl::index size, Reader reader, Writer writer);
+
+  /// Appends a compute stage that processes chunks on `threads` threads.
+  Pipeline &addStage(Stage stage, const gsl::index threads = 1);
+  Pipeline &setChunkSize(const gsl::index chunkSize);
+  /// Sets the maximum number of chunks waiting between two stages.
+  Pipeline &setQueueCapacity(const gsl::index capacity);
+
+  /// Processes all chunks. The writer runs on the calling thread.
+  void run() const;
+
+private:
+  struct ComputeStage {
+    Stage function;
+    gsl::index threads;
+  };
+
+  gsl::index m_size;
+  gsl::index m_chunkSize{1};
+  gsl::index m_queueCapacity{2};
+  Reader m_reader;
+  std::vector<ComputeStage> m_stages;
+  Writer m_writer;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,125 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include "except.h"
+#include "slice_pyramid.h"
+
+namespace {
+/// Number of pixels at `level` covering the full-resolution indices
+/// [begin, end).
+gsl::index pixels(const gsl::index begin, const gsl::index end,
+                  const gsl::index level) {
+  return ((end - 1) >> level) - (begin >> level) + 1;
+}
+
+/// Sum of `var` over all dimensions other than `dim0` and `dim1`.
+Variable project(const Variable &var, const Dim dim0, const Dim dim1) {
+  const auto &dims = var.dimensions();
+  for (const auto dim : {dim0, dim1})
+    if (!dims.contains(dim))
+      throw dataset::except::DimensionNotFoundError(dims, dim);
+  const auto dense = toDense(var);
+  const auto in = dense.get<const Data::Value>();
+  const gsl::index size0 = dims.size(dim0);
+  const gsl::index size1 = dims.size(dim1);
+  const gsl::index stride0 = dims.offset(dim0);
+  const gsl::index stride1 = dims.offset(dim1);
+  // Offsets of all elements of the dimensions that are summed over.
+  std::vector<gsl::index> rest{0};
+  for (const auto dim : dims.labels()) {
+    if (dim == dim0 || dim == dim1)
+      continue;
+    std::vector<gsl::index> next;
+    for (const auto offset : rest)
+      for (gsl::index i = 0; i < dims.size(dim); ++i)
+        next.push_back(offset + i * dims.offset(dim));
+    rest = std::move(next);
+  }
+
+  auto out = makeVariable<Data::Value>({{dim0, size0}, {dim1, size1}});
+  out.setUnit(var.unit());
+  auto result = out.get<Data::Value>();
+#pragma omp parallel for
+  for (gsl::index i0 = 0; i0 < size0; ++i0) {
+    auto *row = result.data() + i0 * size1;
+    for (const auto offset : rest) {
+      const auto *source = in.data() + i0 * stride0 + offset;
+      for (gsl::index i1 = 0; i1 < size1; ++i1)
+        row[i1] += source[i1 * stride1];
+    }
+  }
+  return out;
+}
+
+/// Sum of blocks of 2 x 2 pixels. The last pixel of an odd dimension is
+/// carried over as a block of one pixel.
+Variable downsample(const Variable &var, const Dim dim0, const Dim dim1) {
+  const auto &dims = var.dimensions();
+  const gsl::index size0 = dims.size(dim0);
+  const gsl::index size1 = dims.size(dim1);
+  const gsl::index coarse0 = (size0 + 1) / 2;
+  const gsl::index coarse1 = (size1 + 1) / 2;
+  auto out = makeVariable<Data::Value>({{dim0, coarse0}, {dim1, coarse1}});
+  out.setUnit(var.unit());
+  const auto in = var.get<const Data::Value>();
+  auto result = out.get<Data::Value>();
+#pragma omp parallel for
+  for (gsl::index i0 = 0; i0 < coarse0; ++i0)
+    for (gsl::index j0 = 2 * i0; j0 < std::min(2 * i0 + 2, size0); ++j0)
+      for (gsl::index i1 = 0; i1 < coarse1; ++i1)
+        for (gsl::index j1 = 2 * i1; j1 < std::min(2 * i1 + 2, size1); ++j1)
+          result[i0 * coarse1 + i1] += in[j0 * size1 + j1];
+  return out;
+}
+} // namespace
+
+SlicePyramid::SlicePyramid(const Dim dim0, const Dim dim1)
+    : m_dim0(dim0), m_dim1(dim1) {
+  if (dim0 == dim1)
+    throw std::runtime_error(
+        "SlicePyramid: The two dimensions must be different.");
+}
+
+gsl::index SlicePyramid::level(const gsl::index begin0, const gsl::index end0,
+                               const gsl::index begin1, const gsl::index end1,
+                               const gsl::index maxSize0,
+                               const gsl::index maxSize1) {
+  if (begin0 < 0 || begin0 >= end0 || begin1 < 0 || begin1 >= end1)
+    throw std::runtime_error("SlicePyramid: Invalid viewport.");
+  if (maxSize0 < 1 || maxSize1 < 1)
+    throw std::runtime_error("SlicePyramid: Maximum size must be positive.");
+  gsl::index level = 0;
+  while (pixels(begin0, end0, level) > maxSize0 ||
+         pixels(begin1, end1, level) > maxSize1)
+    ++level;
+  return level;
+}
+
+const Variable &SlicePyramid::get(const Variable &var,
+                                  const gsl::index level) const {
+  // Pointer comparison detects mutation as in SummedAreaTable.
+  if (!m_source || &m_source->data() != &var.data() ||
+      m_source->unit() != var.unit()) {
+    m_levels.clear();
+    m_levels.push_back(project(var, m_dim0, m_dim1));
+    m_source = std::make_unique<Variable>(var);
+  }
+  while (static_cast<gsl::index>(m_levels.size()) <= level)
+    m_levels.push_back(downsample(m_levels.back(), m_dim0, m_dim1));
+  return m_levels[level];
+}
+
+Variable SlicePyramid::view(const Variable &var, const gsl::index begin0,
+                            const gsl::index end0, const gsl::index begin1,
+                            const gsl::index end1, const gsl::index maxSize0,
+                            const gsl::index maxSize1) const {
+  const auto &dims = var.dimensions();
+  if (end0 > dims.size(m_dim0) || end1 > dims.size(m_dim1))
+    throw std::runtime_error("SlicePyramid: Invalid viewport.");
+  const auto l = level(begin0, end0, begin1, end1, maxSize0, maxSize1);
+  const auto &levelData = get(var, l);
+  return Variable(levelData(m_dim0, begin0 >> l, ((end0 - 1) >> l) + 1)(
+      m_dim1, begin1 >> l, ((end1 - 1) >> l) + 1));
+}
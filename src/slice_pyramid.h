@@ -0,0 +1,60 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef SLICE_PYRAMID_H
+#define SLICE_PYRAMID_H
+
+#include <memory>
+#include <vector>
+
+#include <gsl/gsl_util>
+
+#include "dimension.h"
+#include "variable.h"
+
+/// Cache of the projection of a variable onto two dimensions, summed over all
+/// other dimensions, at multiple resolutions, e.g., for a slice viewer.
+///
+/// Level 0 is the full-resolution projection, every further level sums blocks
+/// of 2 x 2 pixels of the previous level. Levels are built on first use and
+/// reused as long as the variable passed to `view` shares its data with the
+/// variable the pyramid was built from, see SummedAreaTable for details on
+/// how mutation is detected. Requests for a viewport are thus answered from a
+/// level whose size matches the screen, independent of the size of the data.
+class SlicePyramid {
+public:
+  SlicePyramid(const Dim dim0, const Dim dim1);
+
+  /// Returns the smallest level at which the viewport [begin0, end0) x
+  /// [begin1, end1) is covered by at most `maxSize0` x `maxSize1` pixels.
+  static gsl::index level(const gsl::index begin0, const gsl::index end0,
+                          const gsl::index begin1, const gsl::index end1,
+                          const gsl::index maxSize0,
+                          const gsl::index maxSize1);
+
+  /// Projection of `var` for the viewport [begin0, end0) x [begin1, end1) of
+  /// the full-resolution indices of the two pyramid dimensions, at the level
+  /// given by `level` for the same arguments. The viewport is widened to the
+  /// pixel boundaries of that level, i.e., pixel `i` of the result along
+  /// `dim0` covers the full-resolution indices starting at
+  /// `((begin0 >> level) + i) << level`.
+  Variable view(const Variable &var, const gsl::index begin0,
+                const gsl::index end0, const gsl::index begin1,
+                const gsl::index end1, const gsl::index maxSize0,
+                const gsl::index maxSize1) const;
+
+  /// Returns the number of levels built so far.
+  gsl::index levelCount() const { return m_levels.size(); }
+
+private:
+  const Variable &get(const Variable &var, const gsl::index level) const;
+
+  Dim m_dim0;
+  Dim m_dim1;
+  mutable std::unique_ptr<Variable> m_source;
+  mutable std::vector<Variable> m_levels;
+};
+
+#endif // SLICE_PYRAMID_H
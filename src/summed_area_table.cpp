@@ -0,0 +1,69 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include "summed_area_table.h"
+
+SummedAreaTable::SummedAreaTable(const Dim dim) : m_dim0(dim) {}
+
+SummedAreaTable::SummedAreaTable(const Dim dim0, const Dim dim1)
+    : m_dim0(dim0), m_dim1(dim1) {
+  if (dim0 == dim1)
+    throw std::runtime_error(
+        "SummedAreaTable: The two dimensions must be different.");
+}
+
+const Variable &SummedAreaTable::table(const Variable &var) const {
+  // Pointer comparison detects mutation, since the copy held in m_source
+  // forces copy-on-write of the data of `var`.
+  if (m_table && &m_source->data() == &var.data() &&
+      m_source->unit() == var.unit())
+    return *m_table;
+  auto table = cumsum(var, m_dim0);
+  if (m_dim1 != Dim::Invalid)
+    table = cumsum(table, m_dim1);
+  m_source = std::make_unique<Variable>(var);
+  m_table = std::make_unique<Variable>(std::move(table));
+  return *m_table;
+}
+
+namespace {
+void checkRange(const Dimensions &dims, const Dim dim, const gsl::index begin,
+                const gsl::index end) {
+  if (begin < 0 || end > dims.size(dim) || begin >= end)
+    throw std::runtime_error("SummedAreaTable: Invalid range.");
+}
+} // namespace
+
+Variable SummedAreaTable::sum(const Variable &var, const gsl::index begin,
+                              const gsl::index end) const {
+  if (m_dim1 != Dim::Invalid)
+    throw std::runtime_error(
+        "SummedAreaTable: Table is 2-dimensional, must provide two ranges.");
+  const auto &s = table(var);
+  checkRange(s.dimensions(), m_dim0, begin, end);
+  Variable out(s(m_dim0, end - 1));
+  if (begin > 0)
+    out -= s(m_dim0, begin - 1);
+  return out;
+}
+
+Variable SummedAreaTable::sum(const Variable &var, const gsl::index begin0,
+                              const gsl::index end0, const gsl::index begin1,
+                              const gsl::index end1) const {
+  if (m_dim1 == Dim::Invalid)
+    throw std::runtime_error(
+        "SummedAreaTable: Table is 1-dimensional, must provide one range.");
+  const auto &s = table(var);
+  checkRange(s.dimensions(), m_dim0, begin0, end0);
+  checkRange(s.dimensions(), m_dim1, begin1, end1);
+  Variable out(s(m_dim0, end0 - 1)(m_dim1, end1 - 1));
+  if (begin0 > 0)
+    out -= s(m_dim0, begin0 - 1)(m_dim1, end1 - 1);
+  if (begin1 > 0)
+    out -= s(m_dim0, end0 - 1)(m_dim1, begin1 - 1);
+  if (begin0 > 0 && begin1 > 0)
+    out += s(m_dim0, begin0 - 1)(m_dim1, begin1 - 1);
+  return out;
+}
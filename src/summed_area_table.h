@@ -0,0 +1,48 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef SUMMED_AREA_TABLE_H
+#define SUMMED_AREA_TABLE_H
+
+#include <memory>
+
+#include <gsl/gsl_util>
+
+#include "dimension.h"
+#include "variable.h"
+
+/// Cache of the cumulative sum of a variable along one or two dimensions,
+/// answering sums over index ranges in O(1) per output element.
+///
+/// The table is built on the first call to `sum` and reused as long as the
+/// variable passed to `sum` shares its data with the variable the table was
+/// built from. Any mutation of the variable triggers copy-on-write, since the
+/// cache holds a reference to the data, so a stale table is detected and
+/// rebuilt automatically. Note that this keeps the old data alive until the
+/// table is rebuilt.
+class SummedAreaTable {
+public:
+  explicit SummedAreaTable(const Dim dim);
+  SummedAreaTable(const Dim dim0, const Dim dim1);
+
+  /// Sum of `var` over the range [begin, end) of the table dimension.
+  Variable sum(const Variable &var, const gsl::index begin,
+               const gsl::index end) const;
+  /// Sum of `var` over the rectangle [begin0, end0) x [begin1, end1) of the
+  /// two table dimensions.
+  Variable sum(const Variable &var, const gsl::index begin0,
+               const gsl::index end0, const gsl::index begin1,
+               const gsl::index end1) const;
+
+private:
+  const Variable &table(const Variable &var) const;
+
+  Dim m_dim0;
+  Dim m_dim1{Dim::Invalid};
+  mutable std::unique_ptr<Variable> m_source;
+  mutable std::unique_ptr<Variable> m_table;
+};
+
+#endif // SUMMED_AREA_TABLE_H
@@ -6,6 +6,7 @@
 #ifndef TAGS_H
 #define TAGS_H
 
+#include <complex>
 #include <memory>
 #include <tuple>
 #include <vector>
@@ -191,6 +192,10 @@ struct Data {
     using type = double;
     static constexpr auto unit = Unit::Id::Dimensionless;
   };
+  struct Complex {
+    using type = std::complex<double>;
+    static constexpr auto unit = Unit::Id::Dimensionless;
+  };
   struct StdDev : public detail::ReturnByValuePolicy {
     using type = double;
   };
@@ -220,7 +225,8 @@ struct Data {
   };
 
   using tags = std::tuple<Tof, PulseTime, Value, Variance, StdDev, Int,
-                          DimensionSize, String, History, Events, Table>;
+                          DimensionSize, String, History, Events, Table,
+                          Complex>;
 };
 
 struct Attr {
@@ -271,6 +277,8 @@ template <> constexpr bool is_dimension_coordinate<Coord::RowLabel> = true;
 
 template <class Tag> constexpr Dimension coordinate_dimension = Dim::Invalid;
 template <> constexpr Dimension coordinate_dimension<Coord::Tof> = Dim::Tof;
+template <>
+constexpr Dimension coordinate_dimension<Coord::MonitorTof> = Dim::MonitorTof;
 template <> constexpr Dimension coordinate_dimension<Coord::X> = Dim::X;
 template <> constexpr Dimension coordinate_dimension<Coord::Y> = Dim::Y;
 template <> constexpr Dimension coordinate_dimension<Coord::Z> = Dim::Z;
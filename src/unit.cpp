@@ -51,7 +51,7 @@ Unit multiply<boost::units::si::area>(const boost::units::si::area &a,
   throw std::runtime_error("Unsupported unit on RHS");
 }
 
-Unit operator*(const Unit &a, const Unit &b) {
+Unit multiplyDimensions(const Unit &a, const Unit &b) {
   if (a == Unit{Unit::Id::Dimensionless})
     return b;
   if (b == Unit{Unit::Id::Dimensionless})
@@ -65,3 +65,16 @@ Unit operator*(const Unit &a, const Unit &b) {
     return multiply(boost::units::si::amount{}, b);
   throw std::runtime_error("Unsupported unit on LHS");
 }
+
+Unit operator*(const Unit &a, const Unit &b) {
+  // Dimensions are combined based on the unscaled units, scales multiply.
+  const auto unit = multiplyDimensions(Unit{a.id()}, Unit{b.id()});
+  return {unit.id(), a.scale() * b.scale()};
+}
+
+double conversionFactor(const Unit &from, const Unit &to) {
+  if (from.id() != to.id())
+    throw std::runtime_error("Cannot convert between units of different "
+                             "dimensions");
+  return from.scale() / to.scale();
+}
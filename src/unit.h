@@ -18,21 +18,29 @@ public:
   };
   // TODO should this be explicit?
   Unit() = default;
-  Unit(const Unit::Id id) : m_id(id) {}
+  /// Construct a unit with given physical dimension and scale relative to the
+  /// base (SI) unit, e.g., `Unit(Unit::Id::Length, 1e-3)` for millimetres.
+  Unit(const Unit::Id id, const double scale = 1.0)
+      : m_id(id), m_scale(scale) {}
 
   const Unit::Id &id() const { return m_id; }
+  double scale() const { return m_scale; }
 
 private:
   Id m_id = Id::Dimensionless;
-  // TODO need to support scale
+  double m_scale = 1.0;
 };
 
 inline bool operator==(const Unit &a, const Unit &b) {
-  return a.id() == b.id();
+  return a.id() == b.id() && a.scale() == b.scale();
 }
 inline bool operator!=(const Unit &a, const Unit &b) { return !(a == b); }
 
 Unit operator+(const Unit &a, const Unit &b);
 Unit operator*(const Unit &a, const Unit &b);
 
+/// Returns the factor for converting values given in unit `from` into unit
+/// `to`. Throws if the units have different physical dimensions.
+double conversionFactor(const Unit &from, const Unit &to);
+
 #endif // UNIT_H
@@ -3,44 +3,199 @@
 /// @author Simon Heybrock
 /// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
 /// National Laboratory, and European Spallation Source ERIC.
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <string_view>
+#include <tuple>
+
 #include "variable.h"
 #include "dataset.h"
 #include "except.h"
 #include "variable_view.h"
 
+/// Minimum number of elements for cloning in parallel. Below this the cost of
+/// starting threads exceeds the gain.
+constexpr gsl::index parallelCloneThreshold = 65536;
+
 template <class T> struct CloneHelper {
   static T getModel(const Dimensions &dims) { return T(dims.volume()); }
+
+  /// Returns a deep copy of `model`. Large arrays of trivially copyable
+  /// elements are copied in parallel into uninitialized memory. With a static
+  /// schedule each thread first-touches, and thus places, the pages of the
+  /// range it will later work on.
+  static T copy(const T &model) {
+    using value_type = typename T::value_type;
+    if constexpr (!std::is_const<value_type>::value &&
+                  std::is_trivially_copyable<value_type>::value) {
+      const gsl::index size = model.size();
+      if (size >= parallelCloneThreshold) {
+        T uninitialized(size, T::allocator_type::uninitialized());
+        const auto *source = model.data();
+        auto *target = uninitialized.data();
+#pragma omp parallel for schedule(static)
+        for (gsl::index i = 0; i < size; ++i)
+          target[i] = source[i];
+        // Swap instead of move to drop the special allocator.
+        T out;
+        out.swap(uninitialized);
+        return out;
+      }
+    }
+    return model;
+  }
 };
 
 template <class T> struct CloneHelper<VariableView<T>> {
   static VariableView<T> getModel(const Dimensions &dims) {
     throw std::runtime_error("Cannot resize view.");
   }
+  static VariableView<T> copy(const VariableView<T> &model) { return model; }
 };
 
+template <class T> struct is_variable_view : std::false_type {};
+template <class T>
+struct is_variable_view<VariableView<T>> : std::true_type {};
+
+template <class Range>
+auto asView(const Range &range, const Dimensions &dims) {
+  if constexpr (is_variable_view<Range>::value)
+    return range;
+  else
+    return makeVariableView(range.data(), dims, dims);
+}
+
+/// Calls `op` for all pairs of elements of `a` and `b`. Arguments can be
+/// contiguous ranges such as gsl::span or a VariableView. Iteration over views
+/// uses VariableView::for_each, i.e., nested loops with a vectorizable inner
+/// loop instead of the generic MultiIndex used by VariableView::iterator.
+template <class A, class B, class Op>
+void for_each_pair(const A &a, const B &b, Op op) {
+  if constexpr (is_variable_view<A>::value || is_variable_view<B>::value) {
+    const Dimensions dims = [&]() {
+      if constexpr (is_variable_view<A>::value)
+        return a.dimensions();
+      else
+        return b.dimensions();
+    }();
+    asView(a, dims).for_each(asView(b, dims), op);
+  } else {
+    auto *dataA = a.data();
+    auto *dataB = b.data();
+    const gsl::index size = a.size();
+    for (gsl::index i = 0; i < size; ++i)
+      op(dataA[i], dataB[i]);
+  }
+}
+
+/// Returns true if `pred` holds for all pairs of elements of `a` and `b`,
+/// stopping at the first pair for which it does not. Arguments are as for
+/// for_each_pair.
+template <class A, class B, class Pred>
+bool all_of_pair(const A &a, const B &b, Pred pred) {
+  if constexpr (is_variable_view<A>::value || is_variable_view<B>::value) {
+    const Dimensions dims = [&]() {
+      if constexpr (is_variable_view<A>::value)
+        return a.dimensions();
+      else
+        return b.dimensions();
+    }();
+    return asView(a, dims).all_of(asView(b, dims), pred);
+  } else {
+    const auto *dataA = a.data();
+    const auto *dataB = b.data();
+    const gsl::index size = a.size();
+    for (gsl::index i = 0; i < size; ++i)
+      if (!pred(dataA[i], dataB[i]))
+        return false;
+    return true;
+  }
+}
+
+/// Minimum number of elements for elementwise arithmetic in parallel.
+constexpr gsl::index parallelArithmeticThreshold = 65536;
+
+/// Like for_each_pair, but runs in parallel for large contiguous ranges.
+/// Iterations must be independent.
+template <class A, class B, class Op>
+void parallel_for_each_pair(const A &a, const B &b, Op op) {
+  if constexpr (!is_variable_view<A>::value && !is_variable_view<B>::value) {
+    const gsl::index size = a.size();
+    if (size >= parallelArithmeticThreshold) {
+      auto *dataA = a.data();
+      auto *dataB = b.data();
+#pragma omp parallel for
+      for (gsl::index i = 0; i < size; ++i)
+        op(dataA[i], dataB[i]);
+      return;
+    }
+  }
+  for_each_pair(a, b, op);
+}
+
 template <template <class> class Op, class T> struct ArithmeticHelper {
+  /// Applies `a = Op(a, factor * b)` elementwise. A factor other than 1
+  /// arises from unit conversion, it is applied in the same pass over the data.
   template <class InputView, class OutputView>
-  static void apply(const OutputView &a, const InputView &b) {
-    std::transform(a.begin(), a.end(), b.begin(), a.begin(), Op<T>());
+  static void apply(const OutputView &a, const InputView &b,
+                    const double factor) {
+    if (factor == 1.0) {
+      parallel_for_each_pair(
+          a, b, [](auto &x, const auto &y) { x = Op<T>()(x, y); });
+    } else {
+      // Scaling integers would silently truncate.
+      if constexpr (std::is_floating_point<T>::value)
+        parallel_for_each_pair(a, b, [factor](auto &x, const auto &y) {
+          x = Op<T>()(x, static_cast<T>(factor * y));
+        });
+      else
+        throw std::runtime_error("Cannot apply unit conversion factor to "
+                                 "non-floating-point type.");
+    }
   }
   // These overloads exist only to make the compiler happy, if they are ever
   // called it probably indicates that something is wrong in the call chain.
   template <class Other>
-  static void apply(const gsl::span<const T> &a, const Other &b) {
+  static void apply(const gsl::span<const T> &, const Other &, const double) {
     throw std::runtime_error("Cannot modify data via const view.");
   }
   template <class Other>
-  static void apply(const VariableView<const T> &a, const Other &b) {
+  static void apply(const VariableView<const T> &, const Other &,
+                    const double) {
     throw std::runtime_error("Cannot modify data via const view.");
   }
-  template <class Other> static void apply(const Vector<T> &a, const Other &b) {
+  template <class Other>
+  static void apply(const Vector<T> &, const Other &, const double) {
     throw std::runtime_error("Passed vector to apply, this should not happen.");
   }
 };
 
+/// Minimum number of elements for copying in parallel. Applies only to element
+/// types owning memory, such as strings or nested datasets, where each element
+/// copy is expensive. Other types are bound by memory bandwidth.
+constexpr gsl::index parallelCopyThreshold = 256;
+
 template <class T> struct CopyHelper {
   template <class T1, class T2> static void copy(T1 &view1, T2 &view2) {
-    std::copy(view1.begin(), view1.end(), view2.begin());
+    if constexpr (!std::is_trivially_copyable<T>::value) {
+      const gsl::index size = view1.size();
+      if (size >= parallelCopyThreshold) {
+#pragma omp parallel for
+        for (gsl::index i = 0; i < size; ++i)
+          view2[i] = view1[i];
+        return;
+      }
+    }
+    for_each_pair(view2, view1, [](auto &x, const auto &y) { x = y; });
+  }
+
+  /// Like copy, but moves the elements of the contiguous range `source`.
+  template <class T1, class T2> static void move(T1 &source, T2 &target) {
+    const gsl::index size = source.size();
+#pragma omp parallel for if (size >= parallelCopyThreshold)
+    for (gsl::index i = 0; i < size; ++i)
+      target[i] = std::move(source[i]);
   }
 };
 
@@ -48,13 +203,59 @@ template <class T> struct CopyHelper<const T> {
   template <class T1, class T2> static void copy(T1 &view1, T2 &view2) {
     throw std::runtime_error("Cannot modify data via const view.");
   }
+  template <class T1, class T2> static void move(T1 &view1, T2 &view2) {
+    throw std::runtime_error("Cannot modify data via const view.");
+  }
+};
+
+std::size_t hashCombine(const std::size_t seed, const std::size_t hash) {
+  return seed ^ (hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+/// Hash of the values of a contiguous range. Trivially copyable elements are
+/// hashed as raw bytes. Returns 0 for types without a defined hash.
+template <class T> struct HashHelper {
+  static std::size_t hash(const T *data, const gsl::index size) {
+    if constexpr (std::is_trivially_copyable<T>::value)
+      return std::hash<std::string_view>()(std::string_view(
+          reinterpret_cast<const char *>(data), size * sizeof(T)));
+    else
+      return 0;
+  }
+};
+
+template <> struct HashHelper<std::string> {
+  static std::size_t hash(const std::string *data, const gsl::index size) {
+    std::size_t hash = 0;
+    for (gsl::index i = 0; i < size; ++i)
+      hash = hashCombine(hash, std::hash<std::string>()(data[i]));
+    return hash;
+  }
 };
 
 template <class T1, class T2> bool equal(const T1 &view1, const T2 &view2) {
-  return std::equal(view1.begin(), view1.end(), view2.begin(), view2.end());
+  if (static_cast<gsl::index>(view1.size()) !=
+      static_cast<gsl::index>(view2.size()))
+    return false;
+  return all_of_pair(view1, view2,
+                     [](const auto &a, const auto &b) { return a == b; });
 }
 
 template <class T> class VariableModel;
+template <class T> class SparseModel;
+template <class T> class ConstantModel;
+template <class T> class ProgressionModel;
+template <class T> class LazyModel;
+/// Returns the index of the first bin that can contain `x`. Without further
+/// knowledge about the edges this is the first bin.
+template <class Edges> gsl::index firstBin(const Edges &, const double) {
+  return 0;
+}
+
+gsl::index firstBin(const Progression &edges, const double x) {
+  return std::max(edges.lowerIndex(x), gsl::index{0});
+}
+
 template <class T> struct RebinHelper {
   static void
   rebin(const Dim dim, const T &oldModel, T &newModel,
@@ -109,21 +310,23 @@ template <class T> struct RebinHelper {
   }
 
   // Special rebin version for rebinning inner dimension to a joint new coord.
+  // The edges are either pointers to the coordinate values or a Progression.
+  template <class OldEdges, class NewEdges>
   static void rebinInner(const Dim dim, const VariableModel<T> &oldModel,
-                         VariableModel<T> &newModel,
-                         const VariableModel<T> &oldCoord,
-                         const VariableModel<T> &newCoord) {
+                         VariableModel<T> &newModel, const OldEdges &xold,
+                         const NewEdges &xnew) {
     const auto &oldData = oldModel.m_model;
     auto &newData = newModel.m_model;
     const auto oldSize = oldModel.dimensions().size(dim);
     const auto newSize = newModel.dimensions().size(dim);
     const auto count = oldModel.dimensions().volume() / oldSize;
-    const auto *xold = &*oldCoord.m_model.begin();
-    const auto *xnew = &*newCoord.m_model.begin();
+    // Skip leading bins without overlap, in closed form for progressions.
+    const gsl::index iold0 = firstBin(xold, xnew[0]);
+    const gsl::index inew0 = firstBin(xnew, xold[0]);
 #pragma omp parallel for
     for (gsl::index c = 0; c < count; ++c) {
-      gsl::index iold = 0;
-      gsl::index inew = 0;
+      gsl::index iold = iold0;
+      gsl::index inew = inew0;
       const auto oldOffset = c * oldSize;
       const auto newOffset = c * newSize;
       while ((iold < oldSize) && (inew < newSize)) {
@@ -218,28 +421,42 @@ DISABLE_REBIN_T(std::pair<T, T>)
 DISABLE_REBIN_T(ValueWithDelta<T>)
 DISABLE_REBIN(Dataset)
 DISABLE_REBIN(std::string)
+DISABLE_REBIN(std::complex<double>)
 DISABLE_REBIN_VIEW();
 
+/// Element types of the RHS that are converted on the fly when used in
+/// arithmetic with a LHS of element type T. Only widening conversions are
+/// listed, narrowing such as double to float or int64_t to int32_t is
+/// rejected. Note that int64_t values beyond 2^53 are rounded when converted to
+/// double.
+template <class T> struct PromotableFrom { using type = std::tuple<>; };
+template <> struct PromotableFrom<double> {
+  using type = std::tuple<float, int64_t, int32_t>;
+};
+template <> struct PromotableFrom<int64_t> {
+  using type = std::tuple<int32_t>;
+};
+
 VariableConcept::VariableConcept(const Dimensions &dimensions)
     : m_dimensions(dimensions){};
 
 template <class T> struct ViewHelper {
-  static bool isView() { return false; }
-  static bool isConstView() { return false; }
+  static constexpr bool isView() { return false; }
+  static constexpr bool isConstView() { return false; }
   static const Dimensions &parentDimensions(const T &model) {
     throw std::runtime_error("Not a view. Parent dimensions not defined.");
   }
 };
 template <class T> struct ViewHelper<VariableView<T>> {
-  static bool isView() { return true; }
-  static bool isConstView() { return false; }
+  static constexpr bool isView() { return true; }
+  static constexpr bool isConstView() { return false; }
   static const Dimensions &parentDimensions(const VariableView<T> &view) {
     return view.parentDimensions();
   }
 };
 template <class T> struct ViewHelper<VariableView<const T>> {
-  static bool isView() { return true; }
-  static bool isConstView() { return true; }
+  static constexpr bool isView() { return true; }
+  static constexpr bool isConstView() { return true; }
   static const Dimensions &parentDimensions(const VariableView<const T> &view) {
     return view.parentDimensions();
   }
@@ -247,6 +464,18 @@ template <class T> struct ViewHelper<VariableView<const T>> {
 
 template <class T> struct CastHelper {
   template <class Concept> static auto *getData(Concept &concept) {
+    using value_type = std::remove_const_t<typename T::value_type>;
+    if constexpr (std::is_const<Concept>::value &&
+                  std::is_same<value_type, double>::value) {
+      if (concept.isProgression())
+        return dynamic_cast<const ProgressionModel<value_type> &>(concept)
+            .values()
+            .data();
+      else if (concept.isLazy())
+        return dynamic_cast<const LazyModel<value_type> &>(concept)
+            .values()
+            .data();
+    }
     if (!concept.isView())
       return dynamic_cast<std::conditional_t<std::is_const<Concept>::value,
                                              const VariableModel<T> &,
@@ -292,6 +521,9 @@ template <class T> struct CastHelper {
       std::conditional_t<std::is_const<Concept>::value,
                          const typename T::value_type, typename T::value_type>>
   getView(Concept &concept, const Dimensions &dims) {
+    if constexpr (std::is_const<Concept>::value)
+      if (concept.isConstant())
+        return getConstantView(concept, dims);
     if (!concept.isView()) {
       auto *data = CastHelper<T>::getData(concept);
       return makeVariableView(data, dims, concept.dimensions());
@@ -308,6 +540,9 @@ template <class T> struct CastHelper {
                          const typename T::value_type, typename T::value_type>>
   getView(Concept &concept, const Dimensions &dims, const Dim dim,
           const gsl::index begin) {
+    if constexpr (std::is_const<Concept>::value)
+      if (concept.isConstant())
+        return getConstantView(concept, dims);
     if (!concept.isView()) {
       auto *data = CastHelper<T>::getData(concept);
       gsl::index beginOffset = concept.dimensions().contains(dim)
@@ -320,6 +555,15 @@ template <class T> struct CastHelper {
           typename T::value_type>>>::getView(concept, dims, dim, begin);
     }
   }
+  /// Constant data is read via a view that broadcasts its single element to
+  /// all of `dims`.
+  static VariableView<const typename T::value_type>
+  getConstantView(const VariableConcept &concept, const Dimensions &dims) {
+    return makeVariableView(
+        &dynamic_cast<const ConstantModel<typename T::value_type> &>(concept)
+             .value(),
+        dims, Dimensions{});
+  }
 };
 
 template <class T> struct CastHelper<VariableView<T>> {
@@ -358,6 +602,12 @@ template <class T> struct CastHelper<VariableView<T>> {
           const gsl::index end) {
     if (!concept.isView())
       return CastHelper<Vector<T>>::getSpan(concept, dim, begin, end);
+    // A range covering the full view, e.g., when assigning to a contiguous
+    // slice, is supported.
+    const auto &dims = concept.dimensions();
+    if (dims.contains(dim) ? dims.size(dim) == end - begin
+                           : begin == 0 && end == 1)
+      return getSpan(concept);
     throw std::runtime_error("Creating sub-span of view is not implemented.");
     if (concept.isConstView()) {
       auto *data = CastHelper<VariableView<T>>::getData(concept);
@@ -405,43 +655,1148 @@ template <class T> struct CastHelper<VariableView<T>> {
   }
 };
 
-template <class T> class VariableModel final : public VariableConcept {
+template <class T> class VariableModel final : public VariableConcept {
+public:
+  VariableModel(const Dimensions &dimensions, T model)
+      : VariableConcept(std::move(dimensions)), m_model(std::move(model)) {
+    if (this->dimensions().volume() != m_model.size())
+      throw std::runtime_error("Creating Variable: data size does not match "
+                               "volume given by dimension extents");
+  }
+
+  std::shared_ptr<VariableConcept> clone() const override {
+    return std::make_shared<VariableModel<T>>(dimensions(),
+                                              CloneHelper<T>::copy(m_model));
+  }
+
+  std::unique_ptr<VariableConcept> cloneUnique() const override {
+    return std::make_unique<VariableModel<T>>(dimensions(),
+                                              CloneHelper<T>::copy(m_model));
+  }
+
+  std::shared_ptr<VariableConcept>
+  clone(const Dimensions &dims) const override {
+    return std::make_shared<VariableModel<T>>(dims,
+                                              CloneHelper<T>::getModel(dims));
+  }
+
+  std::unique_ptr<VariableConcept> cloneDense() const override {
+    using value_type = std::remove_const_t<typename T::value_type>;
+    return std::make_unique<VariableModel<Vector<value_type>>>(
+        dimensions(), Vector<value_type>(m_model.begin(), m_model.end()));
+  }
+
+  std::unique_ptr<VariableConcept> makeView() const override {
+    auto &dims = dimensions();
+    return std::make_unique<
+        VariableModel<decltype(CastHelper<T>::getView(*this, dims))>>(
+        dims, CastHelper<T>::getView(*this, dims));
+  }
+
+  std::unique_ptr<VariableConcept> makeView() override {
+    auto &dims = dimensions();
+    return std::make_unique<
+        VariableModel<decltype(CastHelper<T>::getView(*this, dims))>>(
+        dims, CastHelper<T>::getView(*this, dims));
+  }
+
+  std::unique_ptr<VariableConcept>
+  makeView(const Dim dim, const gsl::index begin,
+           const gsl::index end) const override {
+    auto dims = dimensions();
+    if (end == -1)
+      dims.erase(dim);
+    else
+      dims.resize(dim, end - begin);
+    return std::make_unique<VariableModel<decltype(
+        CastHelper<T>::getView(*this, dims, dim, begin))>>(
+        dims, CastHelper<T>::getView(*this, dims, dim, begin));
+  }
+
+  std::unique_ptr<VariableConcept> makeView(const Dim dim,
+                                            const gsl::index begin,
+                                            const gsl::index end) override {
+    auto dims = dimensions();
+    if (end == -1)
+      dims.erase(dim);
+    else
+      dims.resize(dim, end - begin);
+    return std::make_unique<VariableModel<decltype(
+        CastHelper<T>::getView(*this, dims, dim, begin))>>(
+        dims, CastHelper<T>::getView(*this, dims, dim, begin));
+  }
+
+  bool isContiguous() const override {
+    if (!isView())
+      return true;
+    return dimensions().isContiguousIn(
+        ViewHelper<T>::parentDimensions(m_model));
+  }
+  bool isView() const override { return ViewHelper<T>::isView(); }
+  bool isConstView() const override { return ViewHelper<T>::isConstView(); }
+  bool isSparse() const override { return false; }
+  bool isConstant() const override { return false; }
+  bool isProgression() const override { return false; }
+  bool isLazy() const override { return false; }
+
+  std::size_t hash() const override {
+    using value_type = std::remove_const_t<typename T::value_type>;
+    if constexpr (ViewHelper<T>::isView()) {
+      return 0;
+    } else {
+      std::size_t hash =
+          HashHelper<value_type>::hash(m_model.data(), m_model.size());
+      if (hash == 0)
+        return 0;
+      for (gsl::index i = 0; i < dimensions().count(); ++i) {
+        hash = hashCombine(hash,
+                           static_cast<std::size_t>(dimensions().label(i)));
+        hash = hashCombine(hash, dimensions().size(i));
+      }
+      // 0 is reserved for data that cannot be hashed.
+      return hash == 0 ? 1 : hash;
+    }
+  }
+
+  bool operator==(const VariableConcept &other) const override {
+    if (dimensions() != other.dimensions())
+      return false;
+    if (other.isSparse())
+      return other == *this;
+    if (isContiguous()) {
+      if (other.isContiguous() &&
+          dimensions().isContiguousIn(other.dimensions())) {
+        return equal(CastHelper<T>::getSpan(*this),
+                     CastHelper<T>::getSpan(other));
+      } else {
+        return equal(CastHelper<T>::getSpan(*this),
+                     CastHelper<T>::getView(other, dimensions()));
+      }
+    } else {
+      if (other.isContiguous() &&
+          dimensions().isContiguousIn(other.dimensions())) {
+        return equal(m_model, CastHelper<T>::getSpan(other));
+      } else {
+        return equal(m_model, CastHelper<T>::getView(other, dimensions()));
+      }
+    }
+  }
+
+  template <template <class> class Op, class Other>
+  void applyImpl(const VariableConcept &other, const double factor) {
+    using Helper =
+        ArithmeticHelper<Op, std::remove_const_t<typename T::value_type>>;
+    if (isContiguous()) {
+      if (other.isContiguous() &&
+          dimensions().isContiguousIn(other.dimensions())) {
+        Helper::apply(CastHelper<T>::getSpan(*this),
+                      CastHelper<Other>::getSpan(other), factor);
+      } else {
+        Helper::apply(CastHelper<T>::getSpan(*this),
+                      CastHelper<Other>::getView(other, dimensions()), factor);
+      }
+    } else {
+      if (other.isContiguous() &&
+          dimensions().isContiguousIn(other.dimensions())) {
+        Helper::apply(m_model, CastHelper<Other>::getSpan(other), factor);
+      } else {
+        Helper::apply(m_model, CastHelper<Other>::getView(other, dimensions()),
+                      factor);
+      }
+    }
+  }
+
+  template <template <class> class Op, class U>
+  bool tryApplyMixed(const VariableConcept &other, const double factor) {
+    try {
+      applyImpl<Op, Vector<U>>(other, factor);
+      return true;
+    } catch (const std::bad_cast &) {
+      return false;
+    }
+  }
+
+  template <template <class> class Op, class... Us>
+  bool applyMixed(const VariableConcept &other,
+                  [[maybe_unused]] const double factor, std::tuple<Us...>) {
+    return (tryApplyMixed<Op, Us>(other, factor) || ...);
+  }
+
+  /// Dense LHS with sparse RHS, defined after SparseModel.
+  template <template <class> class Op>
+  VariableConcept &applySparse(const VariableConcept &other,
+                               const double factor);
+
+  template <template <class> class Op>
+  VariableConcept &apply(const VariableConcept &other,
+                         const double factor = 1.0) {
+    if (other.isSparse())
+      return applySparse<Op>(other, factor);
+    try {
+      applyImpl<Op, T>(other, factor);
+    } catch (const std::bad_cast &) {
+      // Different element type, try the types that can be promoted to ours.
+      // Conversion happens per element in the kernel, no copy is made.
+      if (!applyMixed<Op>(other, factor,
+                          typename PromotableFrom<std::remove_const_t<
+                              typename T::value_type>>::type{}))
+        throw std::runtime_error("Cannot apply arithmetic operation to "
+                                 "Variables: Underlying data types do not "
+                                 "match.");
+    }
+    return *this;
+  }
+
+  void rebin(const VariableConcept &old, const Dim dim,
+             const VariableConcept &oldCoord,
+             const VariableConcept &newCoord) override {
+    if (old.isConstant() || old.isProgression() || old.isLazy())
+      return rebinDense(*old.cloneDense(), dim, oldCoord, newCoord);
+    rebinDense(old, dim, oldCoord, newCoord);
+  }
+
+  /// Rebins from `old`, which must be a VariableModel<T>.
+  void rebinDense(const VariableConcept &old, const Dim dim,
+                  const VariableConcept &oldCoord,
+                  const VariableConcept &newCoord) {
+    // Dimensions of *this and old are guaranteed to be the same.
+    if (dimensions().label(0) == dim && oldCoord.dimensions().count() == 1 &&
+        newCoord.dimensions().count() == 1) {
+      const auto &oldModel = dynamic_cast<const VariableModel<T> &>(old);
+      withEdges(oldCoord, [&](const auto &xold) {
+        withEdges(newCoord, [&](const auto &xnew) {
+          RebinHelper<T>::rebinInner(dim, oldModel, *this, xold, xnew);
+        });
+      });
+    } else {
+      const auto &oldModel =
+          dynamic_cast<const VariableModel<T> &>(old).m_model;
+      auto oldCoordDims = oldCoord.dimensions();
+      oldCoordDims.resize(dim, oldCoordDims.size(dim) - 1);
+      auto newCoordDims = newCoord.dimensions();
+      newCoordDims.resize(dim, newCoordDims.size(dim) - 1);
+      auto oldCoordView = CastHelper<T>::getView(oldCoord, dimensions());
+      auto newCoordView = CastHelper<T>::getView(newCoord, dimensions());
+      const auto oldOffset = oldCoordDims.offset(dim);
+      const auto newOffset = newCoordDims.offset(dim);
+
+      RebinHelper<T>::rebin(dim, oldModel, m_model, oldCoordView, oldOffset,
+                            newCoordView, newOffset);
+    }
+  }
+
+  /// Calls `f` with the Progression of `coord` if applicable, otherwise with
+  /// a pointer to its values.
+  template <class F>
+  static void withEdges(const VariableConcept &coord, const F &f) {
+    using value_type = std::remove_const_t<typename T::value_type>;
+    if constexpr (std::is_same<value_type, double>::value)
+      if (coord.isProgression())
+        return f(dynamic_cast<const ProgressionModel<value_type> &>(coord)
+                     .progression());
+    f(CastHelper<T>::getSpan(coord).data());
+  }
+
+  void cumsum(const Dim dim) override {
+    using value_type = std::remove_const_t<typename T::value_type>;
+    if constexpr (std::is_arithmetic<value_type>::value &&
+                  !ViewHelper<T>::isView()) {
+      const auto &dims = dimensions();
+      // Any dimension of extent 0, not only `dim`, leaves nothing to do.
+      if (dims.volume() == 0)
+        return;
+      const gsl::index size = dims.size(dim);
+      const gsl::index inner = dims.offset(dim);
+      const gsl::index outer = dims.volume() / (size * inner);
+      // The scan along `dim` is sequential. Parallelize over the outer
+      // dimensions and over blocks of the inner dimensions, the innermost loop
+      // over a block is contiguous and can be vectorized. For `dim` being the
+      // innermost dimension the block size is 1.
+      constexpr gsl::index blockSize = 256;
+      const gsl::index blocks = (inner + blockSize - 1) / blockSize;
+      auto *data = m_model.data();
+#pragma omp parallel for collapse(2)
+      for (gsl::index o = 0; o < outer; ++o) {
+        for (gsl::index b = 0; b < blocks; ++b) {
+          const gsl::index begin = b * blockSize;
+          const gsl::index end = std::min(begin + blockSize, inner);
+          auto *row = data + o * size * inner;
+          for (gsl::index i = 1; i < size; ++i)
+            for (gsl::index j = begin; j < end; ++j)
+              row[i * inner + j] += row[(i - 1) * inner + j];
+        }
+      }
+    } else {
+      throw std::runtime_error(
+          "Not an arithmetic type. Cannot compute cumulative sum.");
+    }
+  }
+
+  VariableConcept &operator+=(const VariableConcept &other) override {
+    return apply<std::plus>(other);
+  }
+
+  VariableConcept &operator-=(const VariableConcept &other) override {
+    return apply<std::minus>(other);
+  }
+
+  VariableConcept &operator*=(const VariableConcept &other) override {
+    return apply<std::multiplies>(other);
+  }
+
+  VariableConcept &plusScaled(const VariableConcept &other,
+                              const double factor) override {
+    return apply<std::plus>(other, factor);
+  }
+
+  VariableConcept &minusScaled(const VariableConcept &other,
+                               const double factor) override {
+    return apply<std::minus>(other, factor);
+  }
+
+  gsl::index size() const override { return m_model.size(); }
+
+  void copy(const VariableConcept &other, const Dim dim,
+            const gsl::index offset, const gsl::index otherBegin,
+            const gsl::index otherEnd) override {
+    if (other.isSparse())
+      return copyDense(*other.cloneDense(), dim, offset, otherBegin, otherEnd);
+    copyDense(other, dim, offset, otherBegin, otherEnd);
+  }
+
+  /// Copies from `other`, which must not be sparse.
+  void copyDense(const VariableConcept &other, const Dim dim,
+                 const gsl::index offset, const gsl::index otherBegin,
+                 const gsl::index otherEnd) {
+    auto iterDims = dimensions();
+    const gsl::index delta = otherEnd - otherBegin;
+    if (iterDims.contains(dim))
+      iterDims.resize(dim, delta);
+
+    auto otherView = CastHelper<T>::getView(other, iterDims, dim, otherBegin);
+    // Four cases for minimizing use of VariableView --- just copy contiguous
+    // range where possible.
+    if (isContiguous() && iterDims.isContiguousIn(dimensions())) {
+      auto target = CastHelper<T>::getSpan(*this, dim, offset, offset + delta);
+      if (other.isContiguous() && iterDims.isContiguousIn(other.dimensions())) {
+        auto source = CastHelper<T>::getSpan(other, dim, otherBegin, otherEnd);
+        CopyHelper<typename T::value_type>::copy(source, target);
+      } else {
+        CopyHelper<typename T::value_type>::copy(otherView, target);
+      }
+    } else {
+      auto view = CastHelper<T>::getView(*this, iterDims, dim, offset);
+      if (other.isContiguous() && iterDims.isContiguousIn(other.dimensions())) {
+        auto source = CastHelper<T>::getSpan(other, dim, otherBegin, otherEnd);
+        CopyHelper<typename T::value_type>::copy(source, view);
+      } else {
+        CopyHelper<typename T::value_type>::copy(otherView, view);
+      }
+    }
+  }
+
+  void move(VariableConcept &other, const Dim dim, const gsl::index offset,
+            const gsl::index otherBegin, const gsl::index otherEnd) override {
+    using value_type = typename T::value_type;
+    // Moving is only beneficial for elements owning memory. We also require
+    // contiguous storage of the same type, everything else is copied.
+    if constexpr (ViewHelper<T>::isView() ||
+                  std::is_const<value_type>::value ||
+                  std::is_trivially_copyable<value_type>::value) {
+      copy(other, dim, offset, otherBegin, otherEnd);
+    } else {
+      auto iterDims = dimensions();
+      const gsl::index delta = otherEnd - otherBegin;
+      if (iterDims.contains(dim))
+        iterDims.resize(dim, delta);
+      if (!dynamic_cast<VariableModel<T> *>(&other) ||
+          !iterDims.isContiguousIn(dimensions()) ||
+          !iterDims.isContiguousIn(other.dimensions()))
+        return copy(other, dim, offset, otherBegin, otherEnd);
+      auto target = CastHelper<T>::getSpan(*this, dim, offset, offset + delta);
+      auto source = CastHelper<T>::getSpan(other, dim, otherBegin, otherEnd);
+      CopyHelper<value_type>::move(source, target);
+    }
+  }
+
+  T m_model;
+};
+
+/// Sparse storage in compressed sparse row (CSR) format. A row is a line along
+/// the innermost dimension, i.e., typically a spectrum, and elements that are
+/// not stored are zero. Operations that cannot be supported without
+/// materializing the full data throw, the variable must be converted to dense
+/// explicitly in that case.
+template <class T> class SparseModel final : public VariableConcept {
+public:
+  explicit SparseModel(const Dimensions &dimensions)
+      : VariableConcept(dimensions), m_offsets(rows() + 1, 0) {}
+
+  static std::unique_ptr<SparseModel<T>>
+  fromDense(const VariableConcept &dense) {
+    auto sparse = std::make_unique<SparseModel<T>>(dense.dimensions());
+    const auto data = CastHelper<Vector<T>>::getSpan(dense);
+    const gsl::index rows = sparse->rows();
+    const gsl::index columns = sparse->columns();
+    auto &offsets = sparse->m_offsets;
+#pragma omp parallel for
+    for (gsl::index row = 0; row < rows; ++row) {
+      gsl::index count = 0;
+      for (gsl::index col = 0; col < columns; ++col)
+        count += data[row * columns + col] != T{0};
+      offsets[row + 1] = count;
+    }
+    for (gsl::index row = 0; row < rows; ++row)
+      offsets[row + 1] += offsets[row];
+    sparse->m_columns.resize(offsets[rows]);
+    sparse->m_values.resize(offsets[rows]);
+#pragma omp parallel for
+    for (gsl::index row = 0; row < rows; ++row) {
+      gsl::index i = offsets[row];
+      for (gsl::index col = 0; col < columns; ++col) {
+        const auto value = data[row * columns + col];
+        if (value != T{0}) {
+          sparse->m_columns[i] = col;
+          sparse->m_values[i++] = value;
+        }
+      }
+    }
+    return sparse;
+  }
+
+  std::unique_ptr<VariableConcept> cloneDense() const override {
+    Vector<T> dense(dimensions().volume(), T{0});
+    forEachNonZero(
+        [&dense](const gsl::index i, const T value) { dense[i] = value; });
+    return std::make_unique<VariableModel<Vector<T>>>(dimensions(),
+                                                      std::move(dense));
+  }
+
+  gsl::index columns() const {
+    const auto &dims = dimensions();
+    return dims.ndim() == 0 ? 1 : dims.size(dims.ndim() - 1);
+  }
+  gsl::index rows() const {
+    const gsl::index cols = columns();
+    return cols == 0 ? 0 : dimensions().volume() / cols;
+  }
+  gsl::index nonZeros() const { return m_values.size(); }
+
+  /// Calls `f(index, value)` for all stored elements, where `index` is the
+  /// flat index into the dense equivalent. Rows are processed in parallel.
+  template <class F> void forEachNonZero(F f) const {
+    const gsl::index rows = this->rows();
+    const gsl::index columns = this->columns();
+#pragma omp parallel for
+    for (gsl::index row = 0; row < rows; ++row)
+      for (gsl::index i = m_offsets[row]; i < m_offsets[row + 1]; ++i)
+        f(row * columns + m_columns[i], m_values[i]);
+  }
+
+  std::shared_ptr<VariableConcept> clone() const override {
+    return std::make_shared<SparseModel<T>>(*this);
+  }
+
+  std::unique_ptr<VariableConcept> cloneUnique() const override {
+    return std::make_unique<SparseModel<T>>(*this);
+  }
+
+  std::shared_ptr<VariableConcept>
+  clone(const Dimensions &dims) const override {
+    return std::make_shared<SparseModel<T>>(dims);
+  }
+
+  std::unique_ptr<VariableConcept> makeView() const override {
+    throwNoView();
+  }
+  std::unique_ptr<VariableConcept> makeView() override { throwNoView(); }
+  std::unique_ptr<VariableConcept> makeView(const Dim, const gsl::index,
+                                            const gsl::index) const override {
+    throwNoView();
+  }
+  std::unique_ptr<VariableConcept> makeView(const Dim, const gsl::index,
+                                            const gsl::index) override {
+    throwNoView();
+  }
+
+  bool operator==(const VariableConcept &other) const override {
+    if (dimensions() != other.dimensions())
+      return false;
+    const gsl::index columns = this->columns();
+    bool equal = true;
+    if (other.isSparse()) {
+      // Stored zeros are possible, e.g., after subtraction, so we cannot
+      // simply compare the CSR arrays.
+      const auto &o = dynamic_cast<const SparseModel<T> &>(other);
+#pragma omp parallel for reduction(&& : equal)
+      for (gsl::index row = 0; row < rows(); ++row) {
+        gsl::index i = m_offsets[row];
+        gsl::index j = o.m_offsets[row];
+        while (i < m_offsets[row + 1] || j < o.m_offsets[row + 1]) {
+          const gsl::index ci =
+              i < m_offsets[row + 1] ? m_columns[i] : columns;
+          const gsl::index cj =
+              j < o.m_offsets[row + 1] ? o.m_columns[j] : columns;
+          const T a = ci <= cj ? m_values[i] : T{0};
+          const T b = cj <= ci ? o.m_values[j] : T{0};
+          equal = equal && a == b;
+          if (ci <= cj)
+            ++i;
+          if (cj <= ci)
+            ++j;
+        }
+      }
+    } else {
+      const auto view = CastHelper<Vector<T>>::getView(other, dimensions());
+#pragma omp parallel for reduction(&& : equal)
+      for (gsl::index row = 0; row < rows(); ++row) {
+        gsl::index i = m_offsets[row];
+        for (gsl::index col = 0; col < columns; ++col) {
+          const T a = i < m_offsets[row + 1] && m_columns[i] == col
+                          ? m_values[i++]
+                          : T{0};
+          equal = equal && a == view[row * columns + col];
+        }
+      }
+    }
+    return equal;
+  }
+
+  bool isContiguous() const override { return true; }
+  bool isView() const override { return false; }
+  bool isConstView() const override { return false; }
+  bool isSparse() const override { return true; }
+  bool isConstant() const override { return false; }
+  bool isProgression() const override { return false; }
+  bool isLazy() const override { return false; }
+  std::size_t hash() const override { return 0; }
+
+  /// Rebin along the innermost dimension, the result is sparse.
+  void rebin(const VariableConcept &old, const Dim dim,
+             const VariableConcept &oldCoord,
+             const VariableConcept &newCoord) override {
+    if (!old.isSparse() || dimensions().label(dimensions().ndim() - 1) != dim ||
+        oldCoord.dimensions().count() != 1 ||
+        newCoord.dimensions().count() != 1)
+      throw std::runtime_error("Rebinning sparse data is only supported along "
+                               "the innermost dimension with 1-dimensional "
+                               "coordinates.");
+    const auto &oldModel = dynamic_cast<const SparseModel<T> &>(old);
+    const auto xold = CastHelper<Vector<T>>::getSpan(oldCoord);
+    const auto xnew = CastHelper<Vector<T>>::getSpan(newCoord);
+    const gsl::index rows = this->rows();
+    const gsl::index newSize = columns();
+    std::vector<std::vector<std::pair<gsl::index, T>>> result(rows);
+#pragma omp parallel for
+    for (gsl::index row = 0; row < rows; ++row) {
+      auto &out = result[row];
+      for (gsl::index i = oldModel.m_offsets[row];
+           i < oldModel.m_offsets[row + 1]; ++i) {
+        const auto col = oldModel.m_columns[i];
+        const auto xo_low = xold[col];
+        const auto xo_high = xold[col + 1];
+        gsl::index inew =
+            std::upper_bound(xnew.begin(), xnew.end(), xo_low) - xnew.begin();
+        for (inew = std::max(inew - 1, gsl::index{0});
+             inew < newSize && xnew[inew] < xo_high; ++inew) {
+          auto delta = std::min(xo_high, xnew[inew + 1]);
+          delta -= std::max(xo_low, xnew[inew]);
+          if (delta <= 0)
+            continue;
+          const auto value = oldModel.m_values[i] * delta / (xo_high - xo_low);
+          if (!out.empty() && out.back().first == inew)
+            out.back().second += value;
+          else
+            out.emplace_back(inew, value);
+        }
+      }
+    }
+    assign(result);
+  }
+
+  void cumsum(const Dim) override {
+    throw std::runtime_error("Cannot compute cumulative sum of sparse data. "
+                             "Convert to dense first.");
+  }
+
+  VariableConcept &operator+=(const VariableConcept &other) override {
+    return merge<std::plus>(other, 1.0);
+  }
+
+  VariableConcept &operator-=(const VariableConcept &other) override {
+    return merge<std::minus>(other, 1.0);
+  }
+
+  /// Multiplication with dense data keeps the sparsity pattern, i.e., the
+  /// RHS is only read at non-zero elements of the LHS.
+  VariableConcept &operator*=(const VariableConcept &other) override {
+    if (other.isSparse())
+      return merge<std::multiplies>(other, 1.0);
+    const auto view = denseView(other, dimensions());
+    const gsl::index rows = this->rows();
+    const gsl::index columns = this->columns();
+#pragma omp parallel for
+    for (gsl::index row = 0; row < rows; ++row)
+      for (gsl::index i = m_offsets[row]; i < m_offsets[row + 1]; ++i)
+        m_values[i] *= view[row * columns + m_columns[i]];
+    return *this;
+  }
+
+  VariableConcept &plusScaled(const VariableConcept &other,
+                              const double factor) override {
+    return merge<std::plus>(other, factor);
+  }
+
+  VariableConcept &minusScaled(const VariableConcept &other,
+                               const double factor) override {
+    return merge<std::minus>(other, factor);
+  }
+
+  gsl::index size() const override { return dimensions().volume(); }
+
+  /// Same semantics as VariableModel::copy. The source may be sparse or
+  /// dense, only its non-zero elements are inserted.
+  void copy(const VariableConcept &other, const Dim dim,
+            const gsl::index offset, const gsl::index otherBegin,
+            const gsl::index otherEnd) override {
+    const auto &dims = dimensions();
+    const auto &otherDims = other.dimensions();
+    for (const auto label : dims.labels())
+      if (label != dim && !otherDims.contains(label))
+        throw std::runtime_error(
+            "Broadcasting into sparse data is not supported.");
+    std::vector<std::pair<gsl::index, T>> elements;
+    // Keep existing elements outside the target region.
+    const bool hasDim = dims.contains(dim);
+    const gsl::index stride = hasDim ? dims.offset(dim) : 1;
+    const gsl::index extent = hasDim ? dims.size(dim) : 1;
+    const gsl::index delta = otherEnd - otherBegin;
+    if (hasDim)
+      forEachNonZeroSerial([&](const gsl::index i, const T value) {
+        const gsl::index coord = (i / stride) % extent;
+        if (coord < offset || coord >= offset + delta)
+          elements.emplace_back(i, value);
+      });
+    // Map source elements in the source region into the target.
+    const auto target = [&](gsl::index i) {
+      gsl::index index = 0;
+      for (gsl::index d = otherDims.ndim() - 1; d >= 0; --d) {
+        const auto label = otherDims.label(d);
+        const gsl::index size = otherDims.size(d);
+        gsl::index coord = i % size;
+        i /= size;
+        if (label == dim) {
+          if (coord < otherBegin || coord >= otherEnd)
+            return gsl::index{-1};
+          if (!hasDim)
+            continue;
+          coord += offset - otherBegin;
+        } else if (!dims.contains(label)) {
+          throw std::runtime_error(
+              "Cannot copy into sparse data: Dimensions do not match.");
+        }
+        index += coord * dims.offset(label);
+      }
+      return index;
+    };
+    const auto insert = [&](const gsl::index i, const T value) {
+      const auto index = target(i);
+      if (index >= 0)
+        elements.emplace_back(index, value);
+    };
+    if (other.isSparse()) {
+      dynamic_cast<const SparseModel<T> &>(other).forEachNonZeroSerial(insert);
+    } else {
+      const auto view = denseView(other, otherDims);
+      for (gsl::index i = 0; i < otherDims.volume(); ++i)
+        if (view[i] != T{0})
+          insert(i, view[i]);
+    }
+    std::sort(elements.begin(), elements.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::vector<std::vector<std::pair<gsl::index, T>>> result(rows());
+    const gsl::index columns = this->columns();
+    for (const auto &element : elements)
+      result[element.first / columns].emplace_back(element.first % columns,
+                                                   element.second);
+    assign(result);
+  }
+
+  /// Sets this to the data of `other` with slice `i` along `dim` taken from
+  /// slice `source[i]` of `other`. Other dimensions must match. Each row is
+  /// copied, or remapped if `dim` is the innermost dimension, in a single
+  /// pass instead of one call to copy per slice.
+  void gather(const VariableConcept &other, const Dim dim,
+              const std::vector<gsl::index> &source) {
+    const auto &o = dynamic_cast<const SparseModel<T> &>(other);
+    const auto &dims = dimensions();
+    const gsl::index rows = this->rows();
+    const gsl::index columns = this->columns();
+    std::vector<std::vector<std::pair<gsl::index, T>>> result(rows);
+    if (rows > 0 && dims.label(dims.ndim() - 1) == dim) {
+      // Source columns may be used for more than one target column.
+      std::vector<std::vector<gsl::index>> targets(o.columns());
+      for (gsl::index col = 0; col < columns; ++col)
+        targets[source[col]].push_back(col);
+#pragma omp parallel for
+      for (gsl::index row = 0; row < rows; ++row) {
+        auto &out = result[row];
+        for (gsl::index i = o.m_offsets[row]; i < o.m_offsets[row + 1]; ++i)
+          for (const auto col : targets[o.m_columns[i]])
+            out.emplace_back(col, o.m_values[i]);
+        std::sort(out.begin(), out.end(), [](const auto &a, const auto &b) {
+          return a.first < b.first;
+        });
+      }
+    } else if (rows > 0) {
+      const gsl::index stride = dims.offset(dim) / columns;
+      const gsl::index extent = dims.size(dim);
+      const gsl::index otherExtent = other.dimensions().size(dim);
+#pragma omp parallel for
+      for (gsl::index row = 0; row < rows; ++row) {
+        const gsl::index outer = row / (stride * extent);
+        const gsl::index coord = (row / stride) % extent;
+        const gsl::index from =
+            (outer * otherExtent + source[coord]) * stride + row % stride;
+        for (gsl::index i = o.m_offsets[from]; i < o.m_offsets[from + 1]; ++i)
+          result[row].emplace_back(o.m_columns[i], o.m_values[i]);
+      }
+    }
+    assign(result);
+  }
+
+private:
+  [[noreturn]] static void throwNoView() {
+    throw std::runtime_error("Cannot create view of sparse data. Use slice() "
+                             "or convert to dense first.");
+  }
+
+  static VariableView<const T> denseView(const VariableConcept &other,
+                                         const Dimensions &dims) {
+    try {
+      return CastHelper<Vector<T>>::getView(other, dims);
+    } catch (const std::bad_cast &) {
+      throw std::runtime_error("Cannot apply arithmetic operation to "
+                               "Variables: Underlying data types do not "
+                               "match.");
+    }
+  }
+
+  template <class F> void forEachNonZeroSerial(F f) const {
+    const gsl::index columns = this->columns();
+    for (gsl::index row = 0; row < rows(); ++row)
+      for (gsl::index i = m_offsets[row]; i < m_offsets[row + 1]; ++i)
+        f(row * columns + m_columns[i], m_values[i]);
+  }
+
+  /// Replace content by given per-row lists of (column, value).
+  void assign(const std::vector<std::vector<std::pair<gsl::index, T>>> &rows) {
+    const gsl::index count = rows.size();
+    m_offsets.assign(count + 1, 0);
+    for (gsl::index row = 0; row < count; ++row)
+      m_offsets[row + 1] = m_offsets[row] + rows[row].size();
+    m_columns.resize(m_offsets.back());
+    m_values.resize(m_offsets.back());
+#pragma omp parallel for
+    for (gsl::index row = 0; row < count; ++row) {
+      gsl::index i = m_offsets[row];
+      for (const auto &element : rows[row]) {
+        m_columns[i] = element.first;
+        m_values[i++] = element.second;
+      }
+    }
+  }
+
+  /// Elementwise operation with another sparse variable with identical
+  /// dimensions. For multiplication only the intersection of the non-zero
+  /// elements is kept, otherwise the union.
+  template <template <class> class Op>
+  VariableConcept &merge(const VariableConcept &other, const double factor) {
+    if (!other.isSparse() || other.dimensions() != dimensions())
+      throw std::runtime_error("Sparse data can only be combined with sparse "
+                               "data of identical dimensions.");
+    const auto &o = dynamic_cast<const SparseModel<T> &>(other);
+    constexpr bool intersect =
+        std::is_same<Op<T>, std::multiplies<T>>::value;
+    std::vector<std::vector<std::pair<gsl::index, T>>> result(rows());
+#pragma omp parallel for
+    for (gsl::index row = 0; row < rows(); ++row) {
+      auto &out = result[row];
+      gsl::index i = m_offsets[row];
+      gsl::index j = o.m_offsets[row];
+      while (i < m_offsets[row + 1] || j < o.m_offsets[row + 1]) {
+        const bool hasA =
+            i < m_offsets[row + 1] &&
+            (j == o.m_offsets[row + 1] || m_columns[i] <= o.m_columns[j]);
+        const bool hasB =
+            j < o.m_offsets[row + 1] &&
+            (i == m_offsets[row + 1] || o.m_columns[j] <= m_columns[i]);
+        const auto col = hasA ? m_columns[i] : o.m_columns[j];
+        if (!intersect || (hasA && hasB))
+          out.emplace_back(col, Op<T>()(hasA ? m_values[i] : T{0},
+                                        hasB ? factor * o.m_values[j] : T{0}));
+        i += hasA;
+        j += hasB;
+      }
+    }
+    assign(result);
+    return *this;
+  }
+
+  std::vector<gsl::index> m_offsets;
+  std::vector<gsl::index> m_columns;
+  Vector<T> m_values;
+};
+
+/// Dense LHS with sparse RHS. Addition and subtraction touch only the
+/// non-zero elements of the RHS. Multiplication and broadcasting fall back to
+/// a temporary dense copy of the RHS.
+template <class T>
+template <template <class> class Op>
+VariableConcept &VariableModel<T>::applySparse(const VariableConcept &other,
+                                               const double factor) {
+  using value_type = std::remove_const_t<typename T::value_type>;
+  if constexpr (std::is_same<value_type, double>::value &&
+                !ViewHelper<T>::isConstView()) {
+    if (!std::is_same<Op<double>, std::multiplies<double>>::value &&
+        dimensions() == other.dimensions()) {
+      auto view = CastHelper<T>::getView(*this, dimensions());
+      dynamic_cast<const SparseModel<double> &>(other).forEachNonZero(
+          [&view, factor](const gsl::index i, const double value) {
+            view[i] = Op<double>()(view[i], factor * value);
+          });
+      return *this;
+    }
+  }
+  return apply<Op>(*other.cloneDense(), factor);
+}
+
+/// Storage for data with all elements equal to a single value. Reading is
+/// done via views broadcasting the value, so nothing of the size of the
+/// dimensions is allocated. Raw access to the values is therefore not
+/// supported, algorithms requiring it convert to dense first. Only uniform
+/// modifications, i.e., operations with other constant data, are supported.
+/// Variable converts to dense storage before any other write.
+template <class T> class ConstantModel final : public VariableConcept {
+public:
+  ConstantModel(const Dimensions &dimensions, T value)
+      : VariableConcept(dimensions), m_value(std::move(value)) {}
+
+  const T &value() const { return m_value; }
+
+  std::shared_ptr<VariableConcept> clone() const override {
+    return std::make_shared<ConstantModel<T>>(dimensions(), m_value);
+  }
+
+  std::unique_ptr<VariableConcept> cloneUnique() const override {
+    return std::make_unique<ConstantModel<T>>(dimensions(), m_value);
+  }
+
+  std::shared_ptr<VariableConcept>
+  clone(const Dimensions &dims) const override {
+    return std::make_shared<ConstantModel<T>>(dims, m_value);
+  }
+
+  std::unique_ptr<VariableConcept> cloneDense() const override {
+    return std::make_unique<VariableModel<Vector<T>>>(
+        dimensions(), Vector<T>(dimensions().volume(), m_value));
+  }
+
+  std::unique_ptr<VariableConcept> makeView() const override {
+    return makeBroadcastView(dimensions());
+  }
+  std::unique_ptr<VariableConcept> makeView() override { throwNoView(); }
+  std::unique_ptr<VariableConcept>
+  makeView(const Dim dim, const gsl::index begin,
+           const gsl::index end) const override {
+    auto dims = dimensions();
+    if (end == -1)
+      dims.erase(dim);
+    else
+      dims.resize(dim, end - begin);
+    return makeBroadcastView(dims);
+  }
+  std::unique_ptr<VariableConcept> makeView(const Dim, const gsl::index,
+                                            const gsl::index) override {
+    throwNoView();
+  }
+
+  bool operator==(const VariableConcept &other) const override {
+    if (dimensions() != other.dimensions())
+      return false;
+    if (other.isConstant())
+      return m_value == dynamic_cast<const ConstantModel<T> &>(other).m_value;
+    // Progressions and lazy variables defer comparison to their operand,
+    // compare via dense storage.
+    if (other.isProgression() || other.isLazy())
+      return *other.cloneDense() == *this;
+    return other == *this;
+  }
+
+  bool isContiguous() const override { return false; }
+  bool isView() const override { return false; }
+  bool isConstView() const override { return false; }
+  bool isSparse() const override { return false; }
+  bool isConstant() const override { return true; }
+  bool isProgression() const override { return false; }
+  bool isLazy() const override { return false; }
+  std::size_t hash() const override { return 0; }
+
+  void rebin(const VariableConcept &, const Dim, const VariableConcept &,
+             const VariableConcept &) override {
+    throwNonUniform();
+  }
+
+  void cumsum(const Dim) override { throwNonUniform(); }
+
+  VariableConcept &operator+=(const VariableConcept &other) override {
+    return applyUniform(other, [](auto &a, const auto &b) { a += b; });
+  }
+
+  VariableConcept &operator-=(const VariableConcept &other) override {
+    return applyUniform(other, [](auto &a, const auto &b) { a -= b; });
+  }
+
+  VariableConcept &operator*=(const VariableConcept &other) override {
+    return applyUniform(other, [](auto &a, const auto &b) { a *= b; });
+  }
+
+  VariableConcept &plusScaled(const VariableConcept &other,
+                              const double factor) override {
+    return applyUniform(other, [factor](auto &a, const auto &b) {
+      a.plusScaled(b, factor);
+    });
+  }
+
+  VariableConcept &minusScaled(const VariableConcept &other,
+                               const double factor) override {
+    return applyUniform(other, [factor](auto &a, const auto &b) {
+      a.minusScaled(b, factor);
+    });
+  }
+
+  gsl::index size() const override { return dimensions().volume(); }
+
+  void copy(const VariableConcept &, const Dim, const gsl::index,
+            const gsl::index, const gsl::index) override {
+    throwNonUniform();
+  }
+
+private:
+  [[noreturn]] static void throwNoView() {
+    throw std::runtime_error("Cannot create mutable view of constant data. "
+                             "Convert to dense first.");
+  }
+  [[noreturn]] static void throwNonUniform() {
+    throw std::runtime_error("Cannot modify constant data non-uniformly. "
+                             "Convert to dense first.");
+  }
+
+  std::unique_ptr<VariableConcept>
+  makeBroadcastView(const Dimensions &dims) const {
+    return std::make_unique<VariableModel<VariableView<const T>>>(
+        dims, makeVariableView(&m_value, dims, Dimensions{}));
+  }
+
+  /// Applies `op` to the single element, treated as a 0-dimensional dense
+  /// variable. This reuses the type checks and promotion of VariableModel.
+  template <class Op>
+  VariableConcept &applyUniform(const VariableConcept &other, Op op) {
+    if (!other.isConstant())
+      throwNonUniform();
+    VariableModel<Vector<T>> element(Dimensions{}, Vector<T>(1, m_value));
+    op(element, other);
+    m_value = element.m_model[0];
+    return *this;
+  }
+
+  T m_value;
+};
+
+/// Storage for 1-dimensional data given in closed form by a Progression. The
+/// values are generated only if raw access is required, e.g., for views, and
+/// cached. Equality of two progressions compares only the parameters.
+template <class T> class ProgressionModel final : public VariableConcept {
+public:
+  ProgressionModel(const Dimensions &dimensions, const Progression &progression)
+      : VariableConcept(dimensions), m_progression(progression) {
+    if (dimensions.count() != 1)
+      throw std::runtime_error("Progression requires 1-dimensional variable.");
+    if (!(progression.step > (progression.kind == Progression::Kind::Arithmetic
+                                  ? 0.0
+                                  : 1.0)) ||
+        (progression.kind == Progression::Kind::Geometric &&
+         !(progression.start > 0.0)))
+      throw std::runtime_error("Progression must be increasing.");
+  }
+
+  const Progression &progression() const { return m_progression; }
+
+  const Vector<T> &values() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_values) {
+      const gsl::index size = dimensions().volume();
+      m_values = std::make_unique<Vector<T>>(size);
+      auto &values = *m_values;
+#pragma omp parallel for
+      for (gsl::index i = 0; i < size; ++i)
+        values[i] = m_progression[i];
+    }
+    return *m_values;
+  }
+
+  std::shared_ptr<VariableConcept> clone() const override {
+    return std::make_shared<ProgressionModel<T>>(dimensions(), m_progression);
+  }
+
+  std::unique_ptr<VariableConcept> cloneUnique() const override {
+    return std::make_unique<ProgressionModel<T>>(dimensions(), m_progression);
+  }
+
+  std::shared_ptr<VariableConcept>
+  clone(const Dimensions &dims) const override {
+    return std::make_shared<VariableModel<Vector<T>>>(dims,
+                                                      Vector<T>(dims.volume()));
+  }
+
+  std::unique_ptr<VariableConcept> cloneDense() const override {
+    return std::make_unique<VariableModel<Vector<T>>>(dimensions(), values());
+  }
+
+  std::unique_ptr<VariableConcept> makeView() const override {
+    auto &dims = dimensions();
+    return std::make_unique<VariableModel<VariableView<const T>>>(
+        dims, CastHelper<Vector<T>>::getView(*this, dims));
+  }
+  std::unique_ptr<VariableConcept> makeView() override { throwReadOnly(); }
+  std::unique_ptr<VariableConcept>
+  makeView(const Dim dim, const gsl::index begin,
+           const gsl::index end) const override {
+    auto dims = dimensions();
+    if (end == -1)
+      dims.erase(dim);
+    else
+      dims.resize(dim, end - begin);
+    return std::make_unique<VariableModel<VariableView<const T>>>(
+        dims, CastHelper<Vector<T>>::getView(*this, dims, dim, begin));
+  }
+  std::unique_ptr<VariableConcept> makeView(const Dim, const gsl::index,
+                                            const gsl::index) override {
+    throwReadOnly();
+  }
+
+  bool operator==(const VariableConcept &other) const override {
+    if (dimensions() != other.dimensions())
+      return false;
+    if (other.isProgression())
+      return m_progression ==
+             dynamic_cast<const ProgressionModel<T> &>(other).m_progression;
+    return other == *this;
+  }
+
+  bool isContiguous() const override { return true; }
+  bool isView() const override { return false; }
+  bool isConstView() const override { return false; }
+  bool isSparse() const override { return false; }
+  bool isConstant() const override { return false; }
+  bool isProgression() const override { return true; }
+  bool isLazy() const override { return false; }
+  std::size_t hash() const override { return 0; }
+
+  void rebin(const VariableConcept &, const Dim, const VariableConcept &,
+             const VariableConcept &) override {
+    throwReadOnly();
+  }
+  void cumsum(const Dim) override { throwReadOnly(); }
+  VariableConcept &operator+=(const VariableConcept &) override {
+    throwReadOnly();
+  }
+  VariableConcept &operator-=(const VariableConcept &) override {
+    throwReadOnly();
+  }
+  VariableConcept &operator*=(const VariableConcept &) override {
+    throwReadOnly();
+  }
+  VariableConcept &plusScaled(const VariableConcept &, const double) override {
+    throwReadOnly();
+  }
+  VariableConcept &minusScaled(const VariableConcept &,
+                               const double) override {
+    throwReadOnly();
+  }
+
+  gsl::index size() const override { return dimensions().volume(); }
+
+  void copy(const VariableConcept &, const Dim, const gsl::index,
+            const gsl::index, const gsl::index) override {
+    throwReadOnly();
+  }
+
+private:
+  // Variable converts to dense storage before any modification.
+  [[noreturn]] static void throwReadOnly() {
+    throw std::runtime_error(
+        "Cannot modify progression. Convert to dense first.");
+  }
+
+  Progression m_progression;
+  mutable std::mutex m_mutex;
+  mutable std::unique_ptr<Vector<T>> m_values;
+};
+
+/// Model storing a recipe instead of values. The values are computed and
+/// cached on first read access, writes require conversion to dense storage.
+template <class T> class LazyModel final : public VariableConcept {
 public:
-  VariableModel(const Dimensions &dimensions, T model)
-      : VariableConcept(std::move(dimensions)), m_model(std::move(model)) {
-    if (this->dimensions().volume() != m_model.size())
-      throw std::runtime_error("Creating Variable: data size does not match "
-                               "volume given by dimension extents");
+  LazyModel(const Dimensions &dimensions, LazyRecipe recipe)
+      : VariableConcept(dimensions), m_recipe(std::move(recipe)) {
+    const auto arity = m_recipe.unary ? 1 : m_recipe.binary ? 2 : 0;
+    if (arity == 0 || (m_recipe.unary && m_recipe.binary) ||
+        gsl::index(m_recipe.inputs.size()) != arity)
+      throw std::runtime_error(
+          "Lazy recipe requires exactly one operation matching its inputs.");
+    for (const auto &input : m_recipe.inputs)
+      if (!dimensions.contains(input.dimensions()))
+        throw std::runtime_error(
+            "Inputs of lazy variable must be broadcastable to its dimensions.");
+  }
+
+  const LazyRecipe &recipe() const { return m_recipe; }
+
+  const Vector<T> &values() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_values)
+      m_values = std::make_unique<Vector<T>>(compute());
+    return *m_values;
   }
 
   std::shared_ptr<VariableConcept> clone() const override {
-    return std::make_shared<VariableModel<T>>(dimensions(), m_model);
+    return std::make_shared<LazyModel<T>>(dimensions(), m_recipe);
   }
 
   std::unique_ptr<VariableConcept> cloneUnique() const override {
-    return std::make_unique<VariableModel<T>>(dimensions(), m_model);
+    return std::make_unique<LazyModel<T>>(dimensions(), m_recipe);
   }
 
   std::shared_ptr<VariableConcept>
   clone(const Dimensions &dims) const override {
-    return std::make_shared<VariableModel<T>>(dims,
-                                              CloneHelper<T>::getModel(dims));
+    return std::make_shared<VariableModel<Vector<T>>>(dims,
+                                                      Vector<T>(dims.volume()));
   }
 
-  std::unique_ptr<VariableConcept> makeView() const override {
-    auto &dims = dimensions();
-    return std::make_unique<
-        VariableModel<decltype(CastHelper<T>::getView(*this, dims))>>(
-        dims, CastHelper<T>::getView(*this, dims));
+  std::unique_ptr<VariableConcept> cloneDense() const override {
+    return std::make_unique<VariableModel<Vector<T>>>(dimensions(), values());
   }
 
-  std::unique_ptr<VariableConcept> makeView() override {
+  std::unique_ptr<VariableConcept> makeView() const override {
     auto &dims = dimensions();
-    return std::make_unique<
-        VariableModel<decltype(CastHelper<T>::getView(*this, dims))>>(
-        dims, CastHelper<T>::getView(*this, dims));
+    return std::make_unique<VariableModel<VariableView<const T>>>(
+        dims, CastHelper<Vector<T>>::getView(*this, dims));
   }
-
+  std::unique_ptr<VariableConcept> makeView() override { throwReadOnly(); }
+  /// Unless all values have been computed already, only the viewed range is
+  /// computed. It is cached such that the view stays valid for the lifetime
+  /// of this model, just like views onto the cached values.
   std::unique_ptr<VariableConcept>
   makeView(const Dim dim, const gsl::index begin,
            const gsl::index end) const override {
@@ -450,159 +1805,133 @@ public:
       dims.erase(dim);
     else
       dims.resize(dim, end - begin);
-    return std::make_unique<VariableModel<decltype(
-        CastHelper<T>::getView(*this, dims, dim, begin))>>(
-        dims, CastHelper<T>::getView(*this, dims, dim, begin));
-  }
-
-  std::unique_ptr<VariableConcept> makeView(const Dim dim,
-                                            const gsl::index begin,
-                                            const gsl::index end) override {
-    auto dims = dimensions();
-    if (end == -1)
-      dims.erase(dim);
-    else
-      dims.resize(dim, end - begin);
-    return std::make_unique<VariableModel<decltype(
-        CastHelper<T>::getView(*this, dims, dim, begin))>>(
-        dims, CastHelper<T>::getView(*this, dims, dim, begin));
+    if (!dimensions().contains(dim) || hasValues())
+      return std::make_unique<VariableModel<VariableView<const T>>>(
+          dims, CastHelper<Vector<T>>::getView(*this, dims, dim, begin));
+    const auto &values = sliceValues(dims, dim, begin, end);
+    return std::make_unique<VariableModel<VariableView<const T>>>(
+        dims, makeVariableView(values.data(), dims, dims));
   }
-
-  bool isContiguous() const override {
-    if (!isView())
-      return true;
-    return dimensions().isContiguousIn(
-        ViewHelper<T>::parentDimensions(m_model));
+  std::unique_ptr<VariableConcept> makeView(const Dim, const gsl::index,
+                                            const gsl::index) override {
+    throwReadOnly();
   }
-  bool isView() const override { return ViewHelper<T>::isView(); }
-  bool isConstView() const override { return ViewHelper<T>::isConstView(); }
 
   bool operator==(const VariableConcept &other) const override {
     if (dimensions() != other.dimensions())
       return false;
-    if (isContiguous()) {
-      if (other.isContiguous() &&
-          dimensions().isContiguousIn(other.dimensions())) {
-        return equal(CastHelper<T>::getSpan(*this),
-                     CastHelper<T>::getSpan(other));
-      } else {
-        return equal(CastHelper<T>::getSpan(*this),
-                     CastHelper<T>::getView(other, dimensions()));
-      }
-    } else {
-      if (other.isContiguous() &&
-          dimensions().isContiguousIn(other.dimensions())) {
-        return equal(m_model, CastHelper<T>::getSpan(other));
-      } else {
-        return equal(m_model, CastHelper<T>::getView(other, dimensions()));
-      }
-    }
+    // Deferring to `other` would recurse for lazy and progression operands,
+    // compare the computed values instead.
+    return *cloneDense() == other;
   }
 
-  template <template <class> class Op>
-  VariableConcept &apply(const VariableConcept &other) {
-    try {
-      if (isContiguous()) {
-        if (other.isContiguous() &&
-            dimensions().isContiguousIn(other.dimensions())) {
-          ArithmeticHelper<Op, std::remove_const_t<typename T::value_type>>::
-              apply(CastHelper<T>::getSpan(*this),
-                    CastHelper<T>::getSpan(other));
-        } else {
-          ArithmeticHelper<Op, std::remove_const_t<typename T::value_type>>::
-              apply(CastHelper<T>::getSpan(*this),
-                    CastHelper<T>::getView(other, dimensions()));
-        }
-      } else {
-        if (other.isContiguous() &&
-            dimensions().isContiguousIn(other.dimensions())) {
-          ArithmeticHelper<Op, std::remove_const_t<typename T::value_type>>::
-              apply(m_model, CastHelper<T>::getSpan(other));
-        } else {
-          ArithmeticHelper<Op, std::remove_const_t<typename T::value_type>>::
-              apply(m_model, CastHelper<T>::getView(other, dimensions()));
-        }
-      }
-    } catch (const std::bad_cast &) {
-      throw std::runtime_error("Cannot apply arithmetic operation to "
-                               "Variables: Underlying data types do not "
-                               "match.");
-    }
-    return *this;
+  bool isContiguous() const override { return true; }
+  bool isView() const override { return false; }
+  bool isConstView() const override { return false; }
+  bool isSparse() const override { return false; }
+  bool isConstant() const override { return false; }
+  bool isProgression() const override { return false; }
+  bool isLazy() const override { return true; }
+  std::size_t hash() const override { return 0; }
+
+  void rebin(const VariableConcept &, const Dim, const VariableConcept &,
+             const VariableConcept &) override {
+    throwReadOnly();
+  }
+  void cumsum(const Dim) override { throwReadOnly(); }
+  VariableConcept &operator+=(const VariableConcept &) override {
+    throwReadOnly();
+  }
+  VariableConcept &operator-=(const VariableConcept &) override {
+    throwReadOnly();
+  }
+  VariableConcept &operator*=(const VariableConcept &) override {
+    throwReadOnly();
+  }
+  VariableConcept &plusScaled(const VariableConcept &, const double) override {
+    throwReadOnly();
+  }
+  VariableConcept &minusScaled(const VariableConcept &,
+                               const double) override {
+    throwReadOnly();
   }
 
-  void rebin(const VariableConcept &old, const Dim dim,
-             const VariableConcept &oldCoord,
-             const VariableConcept &newCoord) override {
-    // Dimensions of *this and old are guaranteed to be the same.
-    if (dimensions().label(0) == dim && oldCoord.dimensions().count() == 1 &&
-        newCoord.dimensions().count() == 1) {
-      RebinHelper<T>::rebinInner(
-          dim, dynamic_cast<const VariableModel<T> &>(old), *this,
-          dynamic_cast<const VariableModel<T> &>(oldCoord),
-          dynamic_cast<const VariableModel<T> &>(newCoord));
-    } else {
-      const auto &oldModel =
-          dynamic_cast<const VariableModel<T> &>(old).m_model;
-      auto oldCoordDims = oldCoord.dimensions();
-      oldCoordDims.resize(dim, oldCoordDims.size(dim) - 1);
-      auto newCoordDims = newCoord.dimensions();
-      newCoordDims.resize(dim, newCoordDims.size(dim) - 1);
-      auto oldCoordView = CastHelper<T>::getView(oldCoord, dimensions());
-      auto newCoordView = CastHelper<T>::getView(newCoord, dimensions());
-      const auto oldOffset = oldCoordDims.offset(dim);
-      const auto newOffset = newCoordDims.offset(dim);
+  gsl::index size() const override { return dimensions().volume(); }
 
-      RebinHelper<T>::rebin(dim, oldModel, m_model, oldCoordView, oldOffset,
-                            newCoordView, newOffset);
-    }
+  void copy(const VariableConcept &, const Dim, const gsl::index,
+            const gsl::index, const gsl::index) override {
+    throwReadOnly();
   }
 
-  VariableConcept &operator+=(const VariableConcept &other) override {
-    return apply<std::plus>(other);
+private:
+  // Variable converts to dense storage before any modification.
+  [[noreturn]] static void throwReadOnly() {
+    throw std::runtime_error("Cannot modify lazy variable. Convert to dense "
+                             "first.");
   }
 
-  VariableConcept &operator-=(const VariableConcept &other) override {
-    return apply<std::minus>(other);
+  bool hasValues() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<bool>(m_values);
   }
 
-  VariableConcept &operator*=(const VariableConcept &other) override {
-    return apply<std::multiplies>(other);
+  /// Returns the values of the slice with dimensions `dims`, computed from
+  /// the recipe with all inputs depending on `dim` sliced accordingly.
+  const Vector<T> &sliceValues(const Dimensions &dims, const Dim dim,
+                               const gsl::index begin,
+                               const gsl::index end) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto &values = m_slices[std::make_tuple(dim, begin, end)];
+    if (!values) {
+      auto recipe = m_recipe;
+      for (auto &input : recipe.inputs)
+        if (input.dimensions().contains(dim))
+          input = end == -1 ? slice(input, dim, begin)
+                            : slice(input, dim, begin, end);
+      values = std::make_unique<Vector<T>>(
+          LazyModel<T>(dims, std::move(recipe)).compute());
+    }
+    return *values;
   }
 
-  gsl::index size() const override { return m_model.size(); }
-
-  void copy(const VariableConcept &other, const Dim dim,
-            const gsl::index offset, const gsl::index otherBegin,
-            const gsl::index otherEnd) override {
-    auto iterDims = dimensions();
-    const gsl::index delta = otherEnd - otherBegin;
-    if (iterDims.contains(dim))
-      iterDims.resize(dim, delta);
-
-    auto otherView = CastHelper<T>::getView(other, iterDims, dim, otherBegin);
-    // Four cases for minimizing use of VariableView --- just copy contiguous
-    // range where possible.
-    if (isContiguous() && iterDims.isContiguousIn(dimensions())) {
-      auto target = CastHelper<T>::getSpan(*this, dim, offset, offset + delta);
-      if (other.isContiguous() && iterDims.isContiguousIn(other.dimensions())) {
-        auto source = CastHelper<T>::getSpan(other, dim, otherBegin, otherEnd);
-        CopyHelper<typename T::value_type>::copy(source, target);
-      } else {
-        CopyHelper<typename T::value_type>::copy(otherView, target);
+  Vector<T> compute() const {
+    const auto &dims = dimensions();
+    // Sparse inputs have no strided view, expand them to a temporary.
+    std::vector<std::unique_ptr<VariableConcept>> dense;
+    std::vector<VariableView<const T>> views;
+    for (const auto &input : m_recipe.inputs) {
+      const VariableConcept *concept = &input.data();
+      if (concept->isSparse()) {
+        dense.push_back(concept->cloneDense());
+        concept = dense.back().get();
       }
+      views.push_back(CastHelper<Vector<T>>::getView(*concept, dims));
+    }
+    const gsl::index size = dims.volume();
+    Vector<T> values(size);
+    if (m_recipe.unary) {
+      const auto &op = m_recipe.unary;
+      const auto &a = views[0];
+#pragma omp parallel for
+      for (gsl::index i = 0; i < size; ++i)
+        values[i] = op(a[i]);
     } else {
-      auto view = CastHelper<T>::getView(*this, iterDims, dim, offset);
-      if (other.isContiguous() && iterDims.isContiguousIn(other.dimensions())) {
-        auto source = CastHelper<T>::getSpan(other, dim, otherBegin, otherEnd);
-        CopyHelper<typename T::value_type>::copy(source, view);
-      } else {
-        CopyHelper<typename T::value_type>::copy(otherView, view);
-      }
+      const auto &op = m_recipe.binary;
+      const auto &a = views[0];
+      const auto &b = views[1];
+#pragma omp parallel for
+      for (gsl::index i = 0; i < size; ++i)
+        values[i] = op(a[i], b[i]);
     }
+    return values;
   }
 
-  T m_model;
+  LazyRecipe m_recipe;
+  mutable std::mutex m_mutex;
+  mutable std::unique_ptr<Vector<T>> m_values;
+  mutable std::map<std::tuple<Dim, gsl::index, gsl::index>,
+                   std::unique_ptr<Vector<T>>>
+      m_slices;
 };
 
 Variable::Variable(const VariableSlice<const Variable> &slice)
@@ -622,6 +1951,25 @@ Variable::Variable(uint32_t id, const Unit::Id unit,
       m_object(std::make_unique<VariableModel<T>>(std::move(dimensions),
                                                   std::move(object))) {}
 
+template <class T>
+Variable::Variable(uint32_t id, const Unit::Id unit,
+                   const Dimensions &dimensions, ConstantValue<T> value)
+    : m_type(id), m_unit{unit},
+      m_object(std::make_unique<ConstantModel<T>>(dimensions,
+                                                  std::move(value.value))) {}
+
+Variable::Variable(uint32_t id, const Unit::Id unit,
+                   const Dimensions &dimensions, const Progression &progression)
+    : m_type(id), m_unit{unit},
+      m_object(std::make_unique<ProgressionModel<double>>(dimensions,
+                                                          progression)) {}
+
+Variable::Variable(uint32_t id, const Unit::Id unit,
+                   const Dimensions &dimensions, LazyRecipe recipe)
+    : m_type(id), m_unit{unit},
+      m_object(std::make_unique<LazyModel<double>>(dimensions,
+                                                   std::move(recipe))) {}
+
 template <class VarSlice> Variable &Variable::operator=(const VarSlice &slice) {
   m_type = slice.type();
   m_name = slice.m_variable->m_name;
@@ -640,12 +1988,71 @@ void Variable::setDimensions(const Dimensions &dimensions) {
   m_object = m_object->clone(dimensions);
 }
 
+void Variable::makeSparse() {
+  if (isSparse())
+    return;
+  makeDense();
+  if (!dynamic_cast<const VariableModel<Vector<double>> *>(&data()))
+    throw std::runtime_error(
+        "Sparse storage is only supported for element type double.");
+  m_object = std::shared_ptr<VariableConcept>(
+      SparseModel<double>::fromDense(data()));
+}
+
+void Variable::makeDense() {
+  if (isSparse() || isConstant() || isProgression() || isLazy())
+    m_object = std::shared_ptr<VariableConcept>(m_object->cloneDense());
+}
+
+namespace {
+// Above this fraction of non-zero elements sparse storage is not beneficial
+// anymore: CSR needs an index in addition to each value.
+constexpr double sparseDensityThreshold = 0.5;
+
+bool exceedsSparseDensity(const VariableConcept &data) {
+  const auto &sparse = dynamic_cast<const SparseModel<double> &>(data);
+  return sparse.nonZeros() >
+         sparseDensityThreshold * data.dimensions().volume();
+}
+} // namespace
+
+const Progression &Variable::progression() const {
+  if (!isProgression())
+    throw std::runtime_error("Variable is not a progression.");
+  return dynamic_cast<const ProgressionModel<double> &>(*m_object)
+      .progression();
+}
+
+const LazyRecipe &Variable::recipe() const {
+  if (!isLazy())
+    throw std::runtime_error("Variable is not lazy.");
+  return dynamic_cast<const LazyModel<double> &>(*m_object).recipe();
+}
+
 template <class T> const Vector<T> &Variable::cast() const {
+  // Values of a progression or lazy variable are computed and cached on first
+  // access. Constant data is read only via broadcasting views.
+  if (isConstant())
+    throw std::runtime_error("Cannot access data of constant variable "
+                             "directly. Convert to dense first.");
+  if constexpr (std::is_same<T, double>::value) {
+    if (isProgression())
+      return dynamic_cast<const ProgressionModel<double> &>(*m_object)
+          .values();
+    if (isLazy())
+      return dynamic_cast<const LazyModel<double> &>(*m_object).values();
+  }
+  if (isSparse())
+    throw std::runtime_error("Cannot access data of sparse variable "
+                             "directly. Convert to dense first.");
   return dynamic_cast<const VariableModel<Vector<T>> &>(*m_object).m_model;
 }
 
 template <class T> Vector<T> &Variable::cast() {
-  return dynamic_cast<VariableModel<Vector<T>> &>(m_object.access()).m_model;
+  if (isSparse())
+    throw std::runtime_error("Cannot access data of sparse variable "
+                             "directly. Convert to dense first.");
+  return dynamic_cast<VariableModel<Vector<T>> &>(data()).m_model;
 }
 
 #define INSTANTIATE(...)                                                       \
@@ -656,6 +2063,7 @@ template <class T> Vector<T> &Variable::cast() {
 
 INSTANTIATE(std::string)
 INSTANTIATE(double)
+INSTANTIATE(std::complex<double>)
 INSTANTIATE(char)
 INSTANTIATE(int32_t)
 INSTANTIATE(int64_t)
@@ -673,6 +2081,16 @@ INSTANTIATE(std::array<double, 3>)
 INSTANTIATE(std::array<double, 4>)
 INSTANTIATE(std::shared_ptr<std::array<double, 100>>)
 
+#define INSTANTIATE_CONSTANT(...)                                              \
+  template Variable::Variable(uint32_t, const Unit::Id, const Dimensions &,    \
+                              ConstantValue<__VA_ARGS__>);
+
+INSTANTIATE_CONSTANT(double)
+INSTANTIATE_CONSTANT(std::complex<double>)
+INSTANTIATE_CONSTANT(char)
+INSTANTIATE_CONSTANT(int32_t)
+INSTANTIATE_CONSTANT(int64_t)
+
 template <class T> bool Variable::operator==(const T &other) const {
   // Compare even before pointer comparison since data may be shared even if
   // names differ.
@@ -726,18 +2144,34 @@ template <class T> Variable &Variable::operator+=(const T &other) {
   // Addition with different Variable type is supported, mismatch of underlying
   // element types is handled in VariableModel::operator+=.
   // Different name is ok for addition.
-  if (unit() != other.unit())
+  // Different unit scale is ok for addition, the RHS is converted on the fly.
+  if (unit().id() != other.unit().id())
     throw std::runtime_error("Cannot add Variables: Units do not match.");
   if (!valueTypeIs<Data::Events>() && !valueTypeIs<Data::Table>()) {
     if (dimensions().contains(other.dimensions())) {
+      // Sparse data can only be added to sparse data with the same structure,
+      // everything else would fill in the zeros anyway.
+      if (isSparse() && !(other.data().isSparse() &&
+                          other.dimensions() == dimensions()))
+        makeDense();
+      // Adding constant data to constant data keeps it constant. Computed
+      // values (progression or lazy) are read-only.
+      if ((isConstant() && !other.data().isConstant()) || isProgression() ||
+          isLazy())
+        makeDense();
       // Note: This will broadcast/transpose the RHS if required. We do not
       // support changing the dimensions of the LHS though!
-      m_object.access() += other.data();
+      m_object.access().plusScaled(other.data(),
+                                   conversionFactor(other.unit(), unit()));
+      if (isSparse() && exceedsSparseDensity(data()))
+        makeDense();
     } else {
       throw std::runtime_error(
           "Cannot add Variables: Dimensions do not match.");
     }
   } else {
+    if (unit() != other.unit())
+      throw std::runtime_error("Cannot add Variables: Units do not match.");
     if (dimensions() == other.dimensions()) {
       using ConstViewOrRef =
           std::conditional_t<std::is_same<T, Variable>::value,
@@ -767,12 +2201,21 @@ template Variable &Variable::operator+=(const VariableSlice<const Variable> &);
 template Variable &Variable::operator+=(const VariableSlice<Variable> &);
 
 template <class T> Variable &Variable::operator-=(const T &other) {
-  if (unit() != other.unit())
+  if (unit().id() != other.unit().id())
     throw std::runtime_error("Cannot subtract Variables: Units do not match.");
   if (dimensions().contains(other.dimensions())) {
     if (valueTypeIs<Data::Events>())
       throw std::runtime_error("Subtraction of events lists not implemented.");
-    m_object.access() -= other.data();
+    if (isSparse() &&
+        !(other.data().isSparse() && other.dimensions() == dimensions()))
+      makeDense();
+    if ((isConstant() && !other.data().isConstant()) || isProgression() ||
+        isLazy())
+      makeDense();
+    m_object.access().minusScaled(other.data(),
+                                  conversionFactor(other.unit(), unit()));
+    if (isSparse() && exceedsSparseDensity(data()))
+      makeDense();
   } else {
     throw std::runtime_error(
         "Cannot subtract Variables: Dimensions do not match.");
@@ -791,6 +2234,14 @@ template <class T> Variable &Variable::operator*=(const T &other) {
         "Cannot multiply Variables: Dimensions do not match.");
   if (valueTypeIs<Data::Events>())
     throw std::runtime_error("Multiplication of events lists not implemented.");
+  // Multiplication preserves zeros of the LHS, so sparse storage is kept
+  // unless the RHS is sparse with a different structure.
+  if (isSparse() && other.data().isSparse() &&
+      other.dimensions() != dimensions())
+    makeDense();
+  if ((isConstant() && !other.data().isConstant()) || isProgression() ||
+      isLazy())
+    makeDense();
   m_unit = unit() * other.unit();
   m_object.access() *= other.data();
   return *this;
@@ -828,17 +2279,20 @@ VariableSliceMutableMixin<VariableSlice<Variable>>::copyFrom(
 template <class T>
 VariableSlice<Variable> &VariableSliceMutableMixin<VariableSlice<Variable>>::
 operator+=(const T &other) {
-  if (base().unit() != other.unit())
+  if (base().unit().id() != other.unit().id())
     throw std::runtime_error("Cannot add Variables: Units do not match.");
   if (!base().valueTypeIs<Data::Events>() &&
       !base().valueTypeIs<Data::Table>()) {
     if (base().dimensions().contains(other.dimensions())) {
-      base().data() += other.data();
+      base().data().plusScaled(other.data(),
+                               conversionFactor(other.unit(), base().unit()));
     } else {
       throw std::runtime_error(
           "Cannot add Variables: Dimensions do not match.");
     }
   } else {
+    if (base().unit() != other.unit())
+      throw std::runtime_error("Cannot add Variables: Units do not match.");
     if (base().dimensions() == other.dimensions()) {
       using ConstViewOrRef =
           std::conditional_t<std::is_same<T, Variable>::value,
@@ -876,12 +2330,13 @@ operator+=(const VariableSlice<Variable> &);
 template <class T>
 VariableSlice<Variable> &VariableSliceMutableMixin<VariableSlice<Variable>>::
 operator-=(const T &other) {
-  if (base().unit() != other.unit())
+  if (base().unit().id() != other.unit().id())
     throw std::runtime_error("Cannot subtract Variables: Units do not match.");
   if (base().dimensions().contains(other.dimensions())) {
     if (base().valueTypeIs<Data::Events>())
       throw std::runtime_error("Subtraction of events lists not implemented.");
-    base().data() -= other.data();
+    base().data().minusScaled(other.data(),
+                              conversionFactor(other.unit(), base().unit()));
   } else {
     throw std::runtime_error(
         "Cannot subtract Variables: Dimensions do not match.");
@@ -1069,27 +2524,114 @@ Variable operator+(Variable a, const Variable &b) { return a += b; }
 Variable operator-(Variable a, const Variable &b) { return a -= b; }
 Variable operator*(Variable a, const Variable &b) { return a *= b; }
 
-Variable slice(const Variable &var, const Dimension dim,
-               const gsl::index index) {
+namespace {
+/// Returns a lazy variable computing only the given slice of `var`, by slicing
+/// those inputs of the recipe that depend on `dim`.
+template <class... Index>
+Variable sliceLazy(const Variable &var, const Dimension dim,
+                   const Dimensions &dims, const Index... index) {
+  auto recipe = var.recipe();
+  for (auto &input : recipe.inputs)
+    if (input.dimensions().contains(dim))
+      input = slice(input, dim, index...);
+  Variable out(var.type(), var.unit().id(), dims, std::move(recipe));
+  out.setUnit(var.unit());
+  if (!var.name().empty())
+    out.setName(var.name());
+  return out;
+}
+
+/// Copies a range of `source` into `target`, see VariableConcept::copy.
+void transfer(Variable &target, const Variable &source, const Dim dim,
+              const gsl::index offset, const gsl::index begin,
+              const gsl::index end) {
+  target.data().copy(source.data(), dim, offset, begin, end);
+}
+
+/// Like transfer for a const source, but the caller has given up `source`.
+/// Elements are moved unless they are shared with another variable.
+void transfer(Variable &target, Variable &source, const Dim dim,
+              const gsl::index offset, const gsl::index begin,
+              const gsl::index end) {
+  const Variable &in = source;
+  if (!source.isUnique() || in.isSparse() || in.isConstant() ||
+      in.isProgression() || in.isLazy())
+    return transfer(target, in, dim, offset, begin, end);
+  target.data().move(source.data(), dim, offset, begin, end);
+}
+
+/// Returns a copy of `var` with dimensions `dims`, but with default-initialized
+/// values instead of a deep copy that would be overwritten anyway.
+Variable makeUninitialized(const Variable &var, const Dimensions &dims) {
+  auto out(var);
+  // setDimensions keeps the values if the dimensions do not change.
+  if (dims == var.dimensions())
+    out.setDimensions(Dimensions{});
+  out.setDimensions(dims);
+  return out;
+}
+
+template <class Var>
+Variable sliceImpl(Var &var, const Dimension dim, const gsl::index index) {
   auto out(var);
   auto dims = out.dimensions();
   dims.erase(dim);
+  if (var.isLazy())
+    return sliceLazy(var, dim, dims, index);
   out.setDimensions(dims);
-  out.data().copy(var.data(), dim, 0, index, index + 1);
+  // A slice of constant data is constant, resizing is sufficient.
+  if (out.isConstant())
+    return out;
+  transfer(out, var, dim, 0, index, index + 1);
   return out;
 }
 
-Variable slice(const Variable &var, const Dimension dim, const gsl::index begin,
-               const gsl::index end) {
+template <class Var>
+Variable sliceImpl(Var &var, const Dimension dim, const gsl::index begin,
+                   const gsl::index end) {
   auto out(var);
   auto dims = out.dimensions();
   dims.resize(dim, end - begin);
   if (dims == out.dimensions())
     return out;
+  if (var.isLazy())
+    return sliceLazy(var, dim, dims, begin, end);
+  if (var.isProgression()) {
+    // A slice of a progression is a progression with shifted start.
+    auto progression = var.progression();
+    progression.start = progression[begin];
+    out = Variable(var.type(), var.unit().id(), dims, progression);
+    out.setUnit(var.unit());
+    if (!var.name().empty())
+      out.setName(var.name());
+    return out;
+  }
   out.setDimensions(dims);
-  out.data().copy(var.data(), dim, 0, begin, end);
+  if (out.isConstant())
+    return out;
+  transfer(out, var, dim, 0, begin, end);
   return out;
 }
+} // namespace
+
+Variable slice(const Variable &var, const Dimension dim,
+               const gsl::index index) {
+  return sliceImpl(var, dim, index);
+}
+
+Variable slice(Variable &&var, const Dimension dim, const gsl::index index) {
+  return sliceImpl(var, dim, index);
+}
+
+Variable slice(const Variable &var, const Dimension dim, const gsl::index begin,
+               const gsl::index end) {
+  return sliceImpl(var, dim, begin, end);
+}
+
+Variable slice(Variable &&var, const Dimension dim, const gsl::index begin,
+               const gsl::index end) {
+  return sliceImpl(var, dim, begin, end);
+}
 
 // Example of a "derived" operation: Implementation does not require adding a
 // virtual function to VariableConcept.
@@ -1106,8 +2648,9 @@ std::vector<Variable> split(const Variable &var, const Dim dim,
   return vars;
 }
 
-Variable concatenate(const Variable &a1, const Variable &a2,
-                     const Dimension dim) {
+namespace {
+template <class Var>
+Variable concatenateImpl(Var &a1, Var &a2, const Dimension dim) {
   if (a1.type() != a2.type())
     throw std::runtime_error(
         "Cannot concatenate Variables: Data types do not match.");
@@ -1159,11 +2702,21 @@ Variable concatenate(const Variable &a1, const Variable &a2,
     dims.add(dim, extent1 + extent2);
   out.setDimensions(dims);
 
-  out.data().copy(a1.data(), dim, 0, 0, extent1);
-  out.data().copy(a2.data(), dim, extent1, 0, extent2);
+  transfer(out, a1, dim, 0, 0, extent1);
+  transfer(out, a2, dim, extent1, 0, extent2);
 
   return out;
 }
+} // namespace
+
+Variable concatenate(const Variable &a1, const Variable &a2,
+                     const Dimension dim) {
+  return concatenateImpl(a1, a2, dim);
+}
+
+Variable concatenate(Variable &&a1, Variable &&a2, const Dimension dim) {
+  return concatenateImpl(a1, a2, dim);
+}
 
 Variable rebin(const Variable &var, const Variable &oldCoord,
                const Variable &newCoord) {
@@ -1177,15 +2730,96 @@ Variable rebin(const Variable &var, const Variable &oldCoord,
   return rebinned;
 }
 
+namespace {
+/// Returns true if `indices` contains every index in [0, size) exactly once.
+bool isPermutation(const std::vector<gsl::index> &indices,
+                   const gsl::index size) {
+  if (static_cast<gsl::index>(indices.size()) != size)
+    return false;
+  std::vector<bool> seen(size, false);
+  for (const auto i : indices) {
+    if (i < 0 || i >= size || seen[i])
+      return false;
+    seen[i] = true;
+  }
+  return true;
+}
+
+/// Returns sparse data with dimensions `dims` and slice `i` along `dim` taken
+/// from slice `source[i]` of `var`. Copying slice by slice would rebuild the
+/// CSR arrays for every slice.
+Variable gatherSparse(const Variable &var, const Dim dim,
+                      const Dimensions &dims,
+                      const std::vector<gsl::index> &source) {
+  auto out = makeUninitialized(var, dims);
+  dynamic_cast<SparseModel<double> &>(out.data())
+      .gather(var.data(), dim, source);
+  return out;
+}
+
+template <class Var>
+Variable permuteImpl(Var &var, const Dimension dim,
+                     const std::vector<gsl::index> &indices) {
+  const auto size = static_cast<gsl::index>(indices.size());
+  const gsl::index extent = var.dimensions()[dim];
+  const auto inRange = [extent](const gsl::index i) {
+    return i >= 0 && i < extent;
+  };
+  if (var.isSparse() && size <= extent &&
+      std::all_of(indices.begin(), indices.end(), inRange)) {
+    // Slices not listed in `indices` keep their values.
+    std::vector<gsl::index> source(extent);
+    std::iota(source.begin(), source.end(), 0);
+    std::copy(indices.begin(), indices.end(), source.begin());
+    return gatherSparse(var, dim, var.dimensions(), source);
+  }
+  // Slices not listed in `indices` keep their values and repeated indices
+  // read a slice more than once, so anything but a full permutation copies.
+  if (!isPermutation(indices, var.dimensions()[dim])) {
+    auto permuted(var);
+    for (gsl::index i = 0; i < size; ++i)
+      permuted.data().copy(var.data(), dim, i, indices[i], indices[i] + 1);
+    return permuted;
+  }
+  auto permuted = makeUninitialized(var, var.dimensions());
+  for (gsl::index i = 0; i < size; ++i)
+    transfer(permuted, var, dim, i, indices[i], indices[i] + 1);
+  return permuted;
+}
+} // namespace
+
 Variable permute(const Variable &var, const Dimension dim,
                  const std::vector<gsl::index> &indices) {
-  auto permuted(var);
-  for (gsl::index i = 0; i < indices.size(); ++i)
-    permuted.data().copy(var.data(), dim, i, indices[i], indices[i] + 1);
-  return permuted;
+  return permuteImpl(var, dim, indices);
 }
 
-Variable filter(const Variable &var, const Variable &filter) {
+Variable permute(Variable &&var, const Dimension dim,
+                 const std::vector<gsl::index> &indices) {
+  return permuteImpl(var, dim, indices);
+}
+
+Variable cumsum(const Variable &var, const Dim dim) {
+  if (!var.dimensions().contains(dim))
+    throw dataset::except::DimensionNotFoundError(var.dimensions(), dim);
+  auto out(var);
+  out.data().cumsum(dim);
+  return out;
+}
+
+Variable toSparse(const Variable &var) {
+  auto out(var);
+  out.makeSparse();
+  return out;
+}
+
+Variable toDense(const Variable &var) {
+  auto out(var);
+  out.makeDense();
+  return out;
+}
+
+namespace {
+template <class Var> Variable filterImpl(Var &var, const Variable &filter) {
   if (filter.dimensions().ndim() != 1)
     throw std::runtime_error(
         "Cannot filter variable: The filter must by 1-dimensional.");
@@ -1196,9 +2830,17 @@ Variable filter(const Variable &var, const Variable &filter) {
   if (removed == 0)
     return var;
 
-  auto out(var);
-  auto dims = out.dimensions();
+  auto dims = var.dimensions();
   dims.resize(dim, dims.size(dim) - removed);
+  if (var.isSparse()) {
+    std::vector<gsl::index> source;
+    for (gsl::index iIn = 0; iIn < mask.size(); ++iIn)
+      if (mask[iIn])
+        source.push_back(iIn);
+    return gatherSparse(var, dim, dims, source);
+  }
+
+  auto out(var);
   out.setDimensions(dims);
 
   gsl::index iOut = 0;
@@ -1207,6 +2849,15 @@ Variable filter(const Variable &var, const Variable &filter) {
   // type for *every* slice. Should be combined into a single virtual call.
   for (gsl::index iIn = 0; iIn < mask.size(); ++iIn)
     if (mask[iIn])
-      out.data().copy(var.data(), dim, iOut++, iIn, iIn + 1);
+      transfer(out, var, dim, iOut++, iIn, iIn + 1);
   return out;
 }
+} // namespace
+
+Variable filter(const Variable &var, const Variable &filter) {
+  return filterImpl(var, filter);
+}
+
+Variable filter(Variable &&var, const Variable &filter) {
+  return filterImpl(var, filter);
+}
@@ -6,6 +6,9 @@
 #ifndef VARIABLE_H
 #define VARIABLE_H
 
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <string>
 #include <type_traits>
 
@@ -30,6 +33,9 @@ public:
   virtual std::unique_ptr<VariableConcept> cloneUnique() const = 0;
   virtual std::shared_ptr<VariableConcept>
   clone(const Dimensions &dims) const = 0;
+  /// Returns a copy with plain contiguous storage, e.g., for converting sparse
+  /// or constant data.
+  virtual std::unique_ptr<VariableConcept> cloneDense() const = 0;
   virtual std::unique_ptr<VariableConcept> makeView() const = 0;
   virtual std::unique_ptr<VariableConcept> makeView() = 0;
   virtual std::unique_ptr<VariableConcept>
@@ -43,17 +49,39 @@ public:
   virtual bool isContiguous() const = 0;
   virtual bool isView() const = 0;
   virtual bool isConstView() const = 0;
+  virtual bool isSparse() const = 0;
+  virtual bool isConstant() const = 0;
+  virtual bool isProgression() const = 0;
+  virtual bool isLazy() const = 0;
+  /// Returns a hash of dimensions and values, or 0 if the data cannot be
+  /// hashed, e.g., for views or element types without a defined hash.
+  virtual std::size_t hash() const = 0;
 
   virtual void rebin(const VariableConcept &old, const Dim dim,
                      const VariableConcept &oldCoord,
                      const VariableConcept &newCoord) = 0;
+  virtual void cumsum(const Dim dim) = 0;
   virtual VariableConcept &operator+=(const VariableConcept &other) = 0;
   virtual VariableConcept &operator-=(const VariableConcept &other) = 0;
   virtual VariableConcept &operator*=(const VariableConcept &other) = 0;
+  /// Like operator+=, but `other` is multiplied by `factor`, e.g., for unit
+  /// conversion, in the same pass.
+  virtual VariableConcept &plusScaled(const VariableConcept &other,
+                                      const double factor) = 0;
+  /// Like operator-=, but `other` is multiplied by `factor` in the same pass.
+  virtual VariableConcept &minusScaled(const VariableConcept &other,
+                                       const double factor) = 0;
   virtual gsl::index size() const = 0;
   virtual void copy(const VariableConcept &other, const Dim dim,
                     const gsl::index offset, const gsl::index otherBegin,
                     const gsl::index otherEnd) = 0;
+  /// Like copy, but elements of `other` may be moved from, leaving them in a
+  /// valid but unspecified state. Models without owned elements just copy.
+  virtual void move(VariableConcept &other, const Dim dim,
+                    const gsl::index offset, const gsl::index otherBegin,
+                    const gsl::index otherEnd) {
+    copy(other, dim, offset, otherBegin, otherEnd);
+  }
 
   const Dimensions &dimensions() const { return m_dimensions; }
 
@@ -110,6 +138,62 @@ template <class... Tags> class LinearView;
 template <class V> class VariableSlice;
 template <class Base> class VariableSliceMutableMixin;
 
+/// Wrapper for the value of a Variable with constant data, see
+/// makeConstantVariable().
+template <class T> struct ConstantValue {
+  T value;
+};
+
+/// Closed-form values of a 1-dimensional variable, `start + i * step` for an
+/// arithmetic progression or `start * step^i` for a geometric progression.
+/// Only increasing progressions are supported.
+struct Progression {
+  enum class Kind { Arithmetic, Geometric };
+  Kind kind;
+  double start;
+  double step;
+
+  double operator[](const gsl::index i) const {
+    return kind == Kind::Arithmetic ? start + i * step
+                                    : start * std::pow(step, i);
+  }
+
+  /// Returns `i` such that `(*this)[i] <= x < (*this)[i + 1]`. The result is
+  /// not limited to the extent of a variable, i.e., it may be negative. Indices
+  /// beyond the range of gsl::index, e.g., for infinite `x`, are clamped, NaN
+  /// gives the lowest index.
+  gsl::index lowerIndex(const double x) const {
+    constexpr auto lowest = std::numeric_limits<gsl::index>::min();
+    // Keep `i + 1` representable.
+    constexpr auto highest = std::numeric_limits<gsl::index>::max() - 1;
+    if (kind == Kind::Geometric && !(x > 0.0))
+      return lowest;
+    const double index = std::floor(
+        kind == Kind::Arithmetic ? (x - start) / step
+                                 : std::log(x / start) / std::log(step));
+    // 2^62, well within the range of gsl::index. Comparison is false for NaN.
+    constexpr double limit = 4611686018427387904.0;
+    if (!(index > -limit))
+      return lowest;
+    if (index >= limit)
+      return highest;
+    auto i = static_cast<gsl::index>(index);
+    // Correct for rounding errors at bin edges.
+    if ((*this)[i] > x)
+      --i;
+    else if ((*this)[i + 1] <= x)
+      ++i;
+    return i;
+  }
+
+  bool operator==(const Progression &other) const {
+    return kind == other.kind && start == other.start && step == other.step;
+  }
+  bool operator!=(const Progression &other) const { return !(*this == other); }
+};
+
+struct LazyRecipe;
+
 class Variable {
 public:
   // TODO Having this non-explicit is convenient when passing (potential)
@@ -121,6 +205,13 @@ public:
   template <class T>
   Variable(uint32_t id, const Unit::Id unit, const Dimensions &dimensions,
            T object);
+  template <class T>
+  Variable(uint32_t id, const Unit::Id unit, const Dimensions &dimensions,
+           ConstantValue<T> value);
+  Variable(uint32_t id, const Unit::Id unit, const Dimensions &dimensions,
+           const Progression &progression);
+  Variable(uint32_t id, const Unit::Id unit, const Dimensions &dimensions,
+           LazyRecipe recipe);
 
   template <class VarSlice> Variable &operator=(const VarSlice &slice);
 
@@ -161,11 +252,43 @@ public:
 
   gsl::index size() const { return m_object->size(); }
 
+  /// Returns true if the data is stored in sparse format, i.e., only non-zero
+  /// elements are stored.
+  bool isSparse() const { return m_object->isSparse(); }
+  /// Returns true if all elements are equal and only a single value is
+  /// stored. Constant data stays constant under operations with other
+  /// constant data and is converted to dense storage by any other write.
+  /// Raw access via get() requires conversion to dense storage, const slices
+  /// read the single value via a broadcasting view.
+  bool isConstant() const { return m_object->isConstant(); }
+  /// Returns true if the values are given in closed form by a Progression.
+  /// Values are generated on access, equality and bin lookup are O(1).
+  bool isProgression() const { return m_object->isProgression(); }
+  const Progression &progression() const;
+  /// Returns true if the values are computed from a LazyRecipe when accessed.
+  bool isLazy() const { return m_object->isLazy(); }
+  /// Returns true if the data is not shared with another variable, i.e., it
+  /// can be modified or moved from without copying first.
+  bool isUnique() const { return m_object.unique(); }
+  const LazyRecipe &recipe() const;
+  /// Switch to sparse storage. Supported only for element type `double`.
+  /// Arithmetic keeps sparse storage where possible but converts back to dense
+  /// storage once the fraction of non-zero elements becomes large.
+  void makeSparse();
+  /// Switch to dense storage, for sparse or constant data. Does nothing if the
+  /// data is already dense.
+  void makeDense();
+
   const Dimensions &dimensions() const { return m_object->dimensions(); }
   void setDimensions(const Dimensions &dimensions);
 
   const VariableConcept &data() const { return *m_object; }
-  VariableConcept &data() { return m_object.access(); }
+  VariableConcept &data() {
+    // Writes via the returned reference may be non-uniform.
+    if (isConstant() || isProgression() || isLazy())
+      makeDense();
+    return m_object.access();
+  }
 
   template <class Tag> bool valueTypeIs() const {
     return tag_id<Tag> == m_type;
@@ -211,6 +334,7 @@ public:
 
   template <class... Tags> friend class LinearView;
   template <class Base> friend class VariableSliceMutableMixin;
+  friend class VariablePool;
 
 private:
   template <class T> const Vector<T> &cast() const;
@@ -225,6 +349,63 @@ private:
   cow_ptr<VariableConcept> m_object;
 };
 
+/// Returns a variable with all elements set to `value`, storing only a single
+/// element.
+template <class Tag>
+Variable makeConstantVariable(const Dimensions &dimensions,
+                              const typename Tag::type value) {
+  return Variable(tag_id<Tag>, Tag::unit, dimensions,
+                  ConstantValue<typename Tag::type>{value});
+}
+
+/// Recipe for the values of a lazy variable: `unary` or `binary` is applied
+/// elementwise to the one or two inputs, which are broadcast to the dimensions
+/// of the lazy variable. The inputs must have element type double. Holding
+/// the inputs keeps their data alive.
+struct LazyRecipe {
+  std::vector<Variable> inputs;
+  std::function<double(double)> unary;
+  std::function<double(double, double)> binary;
+};
+
+/// Returns a variable with values `op(input)`, computed on first access. If
+/// the variable is sliced, only the slice is computed.
+template <class Tag>
+Variable makeLazyVariable(const Variable &input,
+                          std::function<double(double)> op) {
+  static_assert(std::is_same<typename Tag::type, double>::value,
+                "Lazy variables require element type double.");
+  return Variable(tag_id<Tag>, Tag::unit, input.dimensions(),
+                  LazyRecipe{{input}, std::move(op), {}});
+}
+
+/// Returns a variable with values `op(a, b)`, computed on first access. `b` is
+/// broadcast to the dimensions of `a`.
+template <class Tag>
+Variable makeLazyVariable(const Variable &a, const Variable &b,
+                          std::function<double(double, double)> op) {
+  static_assert(std::is_same<typename Tag::type, double>::value,
+                "Lazy variables require element type double.");
+  return Variable(tag_id<Tag>, Tag::unit, a.dimensions(),
+                  LazyRecipe{{a, b}, {}, std::move(op)});
+}
+
+/// Returns a 1-dimensional variable with values `start + i * step`.
+template <class Tag>
+Variable makeArithmeticProgression(const Dim dim, const gsl::index size,
+                                   const double start, const double step) {
+  return Variable(tag_id<Tag>, Tag::unit, {dim, size},
+                  Progression{Progression::Kind::Arithmetic, start, step});
+}
+
+/// Returns a 1-dimensional variable with values `start * ratio^i`.
+template <class Tag>
+Variable makeGeometricProgression(const Dim dim, const gsl::index size,
+                                  const double start, const double ratio) {
+  return Variable(tag_id<Tag>, Tag::unit, {dim, size},
+                  Progression{Progression::Kind::Geometric, start, ratio});
+}
+
 template <class Tag> Variable makeVariable(const Dimensions &dimensions) {
   return Variable(tag_id<Tag>, Tag::unit, std::move(dimensions),
                   Vector<typename Tag::type>(dimensions.volume()));
@@ -398,14 +579,26 @@ Variable slice(const Variable &var, const Dimension dim,
                const gsl::index index);
 Variable slice(const Variable &var, const Dimension dim, const gsl::index begin,
                const gsl::index end);
+// Overloads for temporaries move elements such as strings or nested datasets
+// instead of copying them, provided that the data is not shared.
+Variable slice(Variable &&var, const Dimension dim, const gsl::index index);
+Variable slice(Variable &&var, const Dimension dim, const gsl::index begin,
+               const gsl::index end);
 std::vector<Variable> split(const Variable &var, const Dim dim,
                             const std::vector<gsl::index> &indices);
 Variable concatenate(const Variable &a1, const Variable &a2,
                      const Dimension dim);
+Variable concatenate(Variable &&a1, Variable &&a2, const Dimension dim);
 Variable rebin(const Variable &var, const Variable &oldCoord,
                const Variable &newCoord);
 Variable permute(const Variable &var, const Dimension dim,
                  const std::vector<gsl::index> &indices);
+Variable permute(Variable &&var, const Dimension dim,
+                 const std::vector<gsl::index> &indices);
 Variable filter(const Variable &var, const Variable &filter);
+Variable filter(Variable &&var, const Variable &filter);
+Variable cumsum(const Variable &var, const Dim dim);
+Variable toSparse(const Variable &var);
+Variable toDense(const Variable &var);
 
 #endif // VARIABLE_H
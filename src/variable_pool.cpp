@@ -0,0 +1,65 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <typeinfo>
+
+#include "dataset.h"
+#include "variable_pool.h"
+
+VariablePool &VariablePool::instance() {
+  static VariablePool pool;
+  return pool;
+}
+
+void VariablePool::intern(Variable &var) {
+  const auto &data = static_cast<const Variable &>(var).data();
+  const auto hash = data.hash();
+  if (hash == 0)
+    return;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const auto range = m_entries.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const auto existing = it->second.lock();
+    if (!existing)
+      continue;
+    if (existing.get() == &data)
+      return;
+    // Data referenced by the pool may have been modified in-place by its last
+    // owner after registration, so the content is always compared. This also
+    // guards against hash collisions.
+    if (typeid(*existing) == typeid(data) && *existing == data) {
+      var.m_object = existing;
+      return;
+    }
+  }
+  m_entries.emplace(hash, var.m_object.weak());
+  if (m_entries.size() > m_pruneThreshold)
+    prune();
+}
+
+void VariablePool::internCoordinates(Dataset &dataset) {
+  auto access = detail::makeAccess(dataset);
+  for (gsl::index i = 0; i < dataset.size(); ++i)
+    if (dataset[i].isCoord())
+      intern(access[i]);
+}
+
+gsl::index VariablePool::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  gsl::index count = 0;
+  for (const auto &entry : m_entries)
+    count += !entry.second.expired();
+  return count;
+}
+
+void VariablePool::prune() {
+  for (auto it = m_entries.begin(); it != m_entries.end();)
+    if (it->second.expired())
+      it = m_entries.erase(it);
+    else
+      ++it;
+  // Doubling keeps the cost of pruning amortized constant per insertion.
+  m_pruneThreshold = std::max(std::size_t{64}, 2 * m_entries.size());
+}
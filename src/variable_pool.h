@@ -0,0 +1,52 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#ifndef VARIABLE_POOL_H
+#define VARIABLE_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <gsl/gsl_util>
+
+#include "variable.h"
+
+class Dataset;
+
+/// Opt-in, process-wide deduplication of variable data.
+///
+/// Interning hashes the data of a variable and, if an identical buffer has been
+/// interned before and is still alive, makes the variable share it. Otherwise
+/// the buffer is registered. The pool holds only weak references, i.e., it
+/// never keeps data alive. Sharing is safe because of copy-on-write, modifying
+/// an interned variable copies its data first.
+///
+/// Typical use is loading many runs of the same instrument, where coordinates
+/// such as detector positions would otherwise be held once per run.
+class VariablePool {
+public:
+  static VariablePool &instance();
+
+  /// Replaces the data of `var` by identical interned data, or registers it.
+  /// Variables whose data cannot be hashed, e.g., sparse data, are unchanged.
+  void intern(Variable &var);
+  /// Interns all coordinate variables of `dataset`.
+  void internCoordinates(Dataset &dataset);
+
+  /// Number of registered buffers that are still alive.
+  gsl::index size() const;
+
+private:
+  VariablePool() = default;
+  void prune();
+
+  mutable std::mutex m_mutex;
+  std::unordered_multimap<std::size_t, std::weak_ptr<VariableConcept>>
+      m_entries;
+  std::size_t m_pruneThreshold{64};
+};
+
+#endif // VARIABLE_POOL_H
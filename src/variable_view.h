@@ -21,7 +21,9 @@ public:
   VariableView(T *variable, const Dimensions &targetDimensions,
                const Dimensions &dimensions)
       : m_variable(variable), m_targetDimensions(targetDimensions),
-        m_dimensions(dimensions) {}
+        m_dimensions(dimensions) {
+    initStrides();
+  }
 
   template <class Other>
   VariableView(const Other &other, const Dimensions &targetDimensions)
@@ -30,6 +32,7 @@ public:
     for (const auto label : m_dimensions.labels())
       if (!other.m_targetDimensions.contains(label))
         m_dimensions.relabel(m_dimensions.index(label), Dim::Invalid);
+    initStrides();
   }
 
   template <class Other>
@@ -37,15 +40,18 @@ public:
                const Dim dim, const gsl::index begin)
       : m_variable(other.m_variable), m_targetDimensions(targetDimensions) {
     m_dimensions = other.m_dimensions;
-    if (begin != 0 || dim != Dim::Invalid)
+    // Slicing a broadcast dimension does not move the data pointer.
+    if ((begin != 0 || dim != Dim::Invalid) && m_dimensions.contains(dim))
       m_variable += begin * m_dimensions.offset(dim);
     for (const auto label : m_dimensions.labels())
       if (!other.m_targetDimensions.contains(label))
         m_dimensions.relabel(m_dimensions.index(label), Dim::Invalid);
+    initStrides();
   }
 
-  friend class VariableView<std::remove_const_t<T>>;
-  friend class VariableView<const T>;
+  // Views with different element types access each others strides, e.g.,
+  // when iterating jointly for arithmetic operations.
+  template <class> friend class VariableView;
 
   class iterator
       : public boost::iterator_facade<iterator, T,
@@ -85,25 +91,136 @@ public:
   iterator end() const {
     return {m_variable, m_targetDimensions, m_dimensions, size()};
   }
-  auto &operator[](const gsl::index i) const { return *(begin() + i); }
+  /// Random access based on precomputed strides. In contrast to `begin() + i`
+  /// this does not require setting up a MultiIndex.
+  T &operator[](const gsl::index i) const { return m_variable[offset(i)]; }
 
   const T *data() const { return m_variable; }
   T *data() { return m_variable; }
 
   gsl::index size() const { return m_targetDimensions.volume(); }
 
+  const Dimensions &dimensions() const { return m_targetDimensions; }
+
   bool operator==(const VariableView<T> &other) const {
     if (m_targetDimensions != other.m_targetDimensions)
       return false;
-    return std::equal(begin(), end(), other.begin());
+    return all_of(other, [](const T &a, const T &b) { return a == b; });
   }
 
   const Dimensions &parentDimensions() const { return m_dimensions; }
 
+  /// Calls `f` for every element of the view, in the order given by the
+  /// target dimensions. The implementation uses nested loops such that the
+  /// innermost loop can be vectorized by the compiler.
+  template <class F> void for_each(F &&f) const {
+    nestedLoop(*this, *this, [&f](T &a, T &) {
+      f(a);
+      return true;
+    });
+  }
+
+  /// Calls `op` for every pair of elements of *this and `other`. Both views
+  /// must have identical target dimensions.
+  template <class Other, class Op>
+  void for_each(const VariableView<Other> &other, Op &&op) const {
+    nestedLoop(*this, other, [&op](auto &a, auto &b) {
+      op(a, b);
+      return true;
+    });
+  }
+
+  /// Returns true if `pred` holds for every pair of elements of *this and
+  /// `other`, stopping at the first pair for which it does not.
+  template <class Other, class Pred>
+  bool all_of(const VariableView<Other> &other, Pred &&pred) const {
+    return nestedLoop(*this, other, pred);
+  }
+
 private:
+  void initStrides() {
+    // Target dimensions that are not part of the parent are broadcast, i.e.,
+    // have stride 0.
+    gsl::index contiguousStride = 1;
+    m_contiguous = true;
+    for (int32_t d = m_targetDimensions.ndim() - 1; d >= 0; --d) {
+      const auto label = m_targetDimensions.label(d);
+      m_strides[d] =
+          m_dimensions.contains(label) ? m_dimensions.offset(label) : 0;
+      if (m_strides[d] != contiguousStride && m_targetDimensions.size(d) != 1)
+        m_contiguous = false;
+      contiguousStride *= m_targetDimensions.size(d);
+    }
+  }
+
+  gsl::index offset(gsl::index i) const {
+    if (m_contiguous)
+      return i;
+    gsl::index offset{0};
+    for (int32_t d = m_targetDimensions.ndim() - 1; d >= 0; --d) {
+      const auto extent = m_targetDimensions.size(d);
+      offset += (i % extent) * m_strides[d];
+      i /= extent;
+    }
+    return offset;
+  }
+
+  /// Calls `op` for pairs of elements until it returns false. Returns false
+  /// if iteration was stopped early.
+  template <class T1, class T2, class Op>
+  static bool nestedLoop(const VariableView<T1> &a, const VariableView<T2> &b,
+                         Op &&op) {
+    const auto &dims = a.m_targetDimensions;
+    const auto volume = dims.volume();
+    if (volume == 0)
+      return true;
+    T1 *dataA = a.m_variable;
+    T2 *dataB = b.m_variable;
+    if (a.m_contiguous && b.m_contiguous) {
+      for (gsl::index i = 0; i < volume; ++i)
+        if (!op(dataA[i], dataB[i]))
+          return false;
+      return true;
+    }
+    const int32_t ndim = dims.ndim();
+    const auto inner = dims.size(ndim - 1);
+    const auto strideA = a.m_strides[ndim - 1];
+    const auto strideB = b.m_strides[ndim - 1];
+    gsl::index coord[6]{0, 0, 0, 0, 0, 0};
+    gsl::index offsetA{0};
+    gsl::index offsetB{0};
+    for (gsl::index outer = 0; outer < volume / inner; ++outer) {
+      T1 *rowA = dataA + offsetA;
+      T2 *rowB = dataB + offsetB;
+      // Separate branch for the common case of a contiguous inner dimension,
+      // giving the compiler a chance to vectorize.
+      if (strideA == 1 && strideB == 1) {
+        for (gsl::index i = 0; i < inner; ++i)
+          if (!op(rowA[i], rowB[i]))
+            return false;
+      } else {
+        for (gsl::index i = 0; i < inner; ++i)
+          if (!op(rowA[i * strideA], rowB[i * strideB]))
+            return false;
+      }
+      for (int32_t d = ndim - 2; d >= 0; --d) {
+        offsetA += a.m_strides[d];
+        offsetB += b.m_strides[d];
+        if (++coord[d] < dims.size(d))
+          break;
+        offsetA -= coord[d] * a.m_strides[d];
+        offsetB -= coord[d] * b.m_strides[d];
+        coord[d] = 0;
+      }
+    }
+    return true;
+  }
+
   T *m_variable;
   const Dimensions m_targetDimensions;
   Dimensions m_dimensions;
+  gsl::index m_strides[6];
+  bool m_contiguous;
 };
 
 template <class T>
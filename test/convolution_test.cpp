@@ -0,0 +1,147 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "test_macros.h"
+
+#include "convolution.h"
+
+TEST(Convolution, convolve_inner) {
+  auto var =
+      makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 4}},
+                                {1.0, 2.0, 3.0, 4.0, 0.0, 1.0, 0.0, 0.0});
+  auto result = convolve(var, Dim::X, {1.0, 2.0, 3.0});
+  // Same as numpy.convolve(..., mode="same").
+  EXPECT_TRUE(equals(result.get<const Data::Value>(),
+                     {4.0, 10.0, 16.0, 17.0, 1.0, 2.0, 3.0, 0.0}));
+}
+
+TEST(Convolution, convolve_outer) {
+  auto var =
+      makeVariable<Data::Value>({{Dim::Y, 4}, {Dim::X, 2}},
+                                {1.0, 0.0, 2.0, 1.0, 3.0, 0.0, 4.0, 0.0});
+  auto result = convolve(var, Dim::Y, {1.0, 2.0, 3.0});
+  EXPECT_TRUE(equals(result.get<const Data::Value>(),
+                     {4.0, 1.0, 10.0, 2.0, 16.0, 3.0, 17.0, 0.0}));
+}
+
+TEST(Convolution, convolve_fft_matches_direct) {
+  const gsl::index n = 300;
+  std::vector<double> values(2 * n);
+  for (gsl::index i = 0; i < 2 * n; ++i)
+    values[i] = std::sin(0.1 * i) + (i % 7);
+  auto var = makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, n}},
+                                       values.begin(), values.end());
+  std::vector<double> kernel(101);
+  std::iota(kernel.begin(), kernel.end(), 1.0);
+  // Long kernel uses FFT, compare with direct evaluation.
+  auto result = convolve(var, Dim::X, kernel);
+  const auto out = result.get<const Data::Value>();
+  const gsl::index length = kernel.size();
+  const gsl::index center = (length - 1) / 2;
+  for (gsl::index y = 0; y < 2; ++y) {
+    for (gsl::index i = 0; i < n; ++i) {
+      double expected = 0.0;
+      for (gsl::index k = 0; k < length; ++k) {
+        const gsl::index j = i + center - k;
+        if (j >= 0 && j < n)
+          expected += kernel[k] * values[y * n + j];
+      }
+      EXPECT_NEAR(out[y * n + i], expected, 1e-9 * std::abs(expected) + 1e-9);
+    }
+  }
+}
+
+TEST(Convolution, rolling) {
+  auto var =
+      makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 4}},
+                                {1.0, 2.0, 3.0, 4.0, 4.0, 1.0, 3.0, 2.0});
+  EXPECT_TRUE(equals(rollingSum(var, Dim::X, 3).get<const Data::Value>(),
+                     {3.0, 6.0, 9.0, 7.0, 5.0, 8.0, 6.0, 5.0}));
+  EXPECT_TRUE(equals(rollingMean(var, Dim::X, 3).get<const Data::Value>(),
+                     {1.5, 2.0, 3.0, 3.5, 2.5, 8.0 / 3, 2.0, 2.5}));
+  EXPECT_TRUE(equals(rollingMax(var, Dim::X, 3).get<const Data::Value>(),
+                     {2.0, 3.0, 4.0, 4.0, 4.0, 4.0, 3.0, 3.0}));
+  EXPECT_TRUE(equals(rollingSum(var, Dim::Y, 2).get<const Data::Value>(),
+                     {5.0, 3.0, 6.0, 6.0, 4.0, 1.0, 3.0, 2.0}));
+  EXPECT_TRUE(equals(rollingMax(var, Dim::Y, 2).get<const Data::Value>(),
+                     {4.0, 2.0, 3.0, 4.0, 4.0, 1.0, 3.0, 2.0}));
+}
+
+TEST(Convolution, zero_extent) {
+  const auto var = makeVariable<Data::Value>({{Dim::Y, 3}, {Dim::X, 0}});
+  for (const auto dim : {Dim::Y, Dim::X}) {
+    EXPECT_EQ(rollingSum(var, dim, 2), var);
+    EXPECT_EQ(rollingMean(var, dim, 2), var);
+    EXPECT_EQ(rollingMax(var, dim, 2), var);
+    EXPECT_EQ(convolve(var, dim, {1.0, 2.0, 1.0}), var);
+    EXPECT_EQ(convolve(var, dim, std::vector<double>(101, 1.0)), var);
+  }
+}
+
+TEST(Convolution, rolling_non_finite) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  auto var = makeVariable<Data::Value>(
+      {{Dim::Y, 2}, {Dim::X, 6}},
+      {1.0, nan, 1.0, 1.0, 1.0, 1.0, inf, 1.0, 1.0, 1.0, -inf, 1.0});
+  const auto sum = rollingSum(var, Dim::X, 3);
+  const auto values = sum.get<const Data::Value>();
+  // Non-finite values affect only the windows containing them.
+  for (const gsl::index i : {0, 1, 2})
+    EXPECT_TRUE(std::isnan(values[i]));
+  EXPECT_EQ(values[3], 3.0);
+  EXPECT_EQ(values[4], 3.0);
+  EXPECT_EQ(values[5], 2.0);
+  EXPECT_EQ(values[6], inf);
+  EXPECT_EQ(values[7], inf);
+  EXPECT_EQ(values[8], 3.0);
+  EXPECT_EQ(values[9], -inf);
+  EXPECT_EQ(values[10], -inf);
+  EXPECT_EQ(values[11], -inf);
+}
+
+TEST(Convolution, dataset_variance) {
+  Dataset d;
+  d.insert<Coord::X>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  d.insert<Data::Value>("", {Dim::X, 3}, {1.0, 2.0, 3.0});
+  d.insert<Data::Variance>("", {Dim::X, 3}, {1.0, 2.0, 3.0});
+
+  auto convolved = convolve(d, Dim::X, {0.5, 0.5});
+  EXPECT_TRUE(equals(convolved.get<const Coord::X>(), {1.0, 2.0, 3.0}));
+  EXPECT_TRUE(equals(convolved.get<const Data::Value>(), {0.5, 1.5, 2.5}));
+  EXPECT_TRUE(
+      equals(convolved.get<const Data::Variance>(), {0.25, 0.75, 1.25}));
+
+  auto mean = rollingMean(d, Dim::X, 3);
+  EXPECT_TRUE(equals(mean.get<const Data::Value>(), {1.5, 2.0, 2.5}));
+  EXPECT_TRUE(equals(mean.get<const Data::Variance>(), {0.75, 6.0 / 9, 1.25}));
+}
+
+TEST(Convolution, dataset_constant_variance) {
+  Dataset d;
+  d.insert<Data::Value>("", {Dim::X, 3}, {1.0, 2.0, 3.0});
+  d.insert(makeConstantVariable<Data::Variance>({Dim::X, 3}, 1.0));
+  auto convolved = convolve(d, Dim::X, {0.5, 0.5});
+  EXPECT_TRUE(
+      equals(convolved.get<const Data::Variance>(), {0.25, 0.5, 0.5}));
+}
+
+TEST(Convolution, fail) {
+  auto var = makeVariable<Data::Value>({Dim::X, 2}, {1.0, 2.0});
+  EXPECT_THROW(convolve(var, Dim::Y, {1.0}),
+               dataset::except::DimensionNotFoundError);
+  EXPECT_THROW_MSG(rollingSum(var, Dim::X, 0), std::runtime_error,
+                   "Window size must be positive.");
+  auto ints = makeVariable<Data::Int>({Dim::X, 2}, {1, 2});
+  EXPECT_THROW_MSG(rollingSum(ints, Dim::X, 2), std::runtime_error,
+                   "Cannot apply kernel: Only Data::Value and Data::Variance "
+                   "are supported.");
+}
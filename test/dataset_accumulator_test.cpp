@@ -0,0 +1,67 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include "test_macros.h"
+
+#include "dataset.h"
+#include "dataset_accumulator.h"
+
+Dataset makeRun(const double value) {
+  Dataset d;
+  d.insert<Coord::X>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  d.insert<Data::Value>("", {Dim::X, 3}, {value, 2.0 * value, 3.0 * value});
+  d.insert<Data::Variance>("", {Dim::X, 3}, {value, value, value});
+  return d;
+}
+
+TEST(DatasetAccumulator, add) {
+  DatasetAccumulator accumulator;
+  EXPECT_THROW_MSG(accumulator.sum(), std::runtime_error,
+                   "DatasetAccumulator: No dataset has been added.");
+  const auto run = makeRun(1.0);
+  accumulator.add(run);
+  accumulator.add(makeRun(2.0));
+  accumulator.add(makeRun(3.0));
+  EXPECT_EQ(accumulator.count(), 3);
+  const auto &sum = accumulator.sum();
+  EXPECT_TRUE(equals(sum.get<const Data::Value>(), {6.0, 12.0, 18.0}));
+  EXPECT_TRUE(equals(sum.get<const Data::Variance>(), {6.0, 6.0, 6.0}));
+  // The first run is not modified by accumulation.
+  EXPECT_TRUE(equals(run.get<const Data::Value>(), {1.0, 2.0, 3.0}));
+}
+
+TEST(DatasetAccumulator, add_chunk) {
+  Dataset chunk;
+  chunk.insert<Coord::X>({Dim::X, 2}, {1.0, 2.0});
+  chunk.insert<Data::Value>("", {{Dim::Run, 3}, {Dim::X, 2}},
+                            {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+  DatasetAccumulator accumulator;
+  accumulator.add(chunk, Dim::Run);
+  accumulator.add(chunk, Dim::Run);
+  EXPECT_EQ(accumulator.count(), 6);
+  EXPECT_EQ(accumulator.sum().dimensions(), Dimensions(Dim::X, 2));
+  EXPECT_TRUE(
+      equals(accumulator.sum().get<const Data::Value>(), {18.0, 24.0}));
+}
+
+TEST(DatasetAccumulator, add_loaded) {
+  DatasetAccumulator accumulator;
+  accumulator.add(4, [](const gsl::index i) { return makeRun(i); });
+  EXPECT_EQ(accumulator.count(), 4);
+  EXPECT_TRUE(
+      equals(accumulator.sum().get<const Data::Value>(), {6.0, 12.0, 18.0}));
+}
+
+TEST(DatasetAccumulator, coordinate_mismatch) {
+  DatasetAccumulator accumulator;
+  accumulator.add(makeRun(1.0));
+  auto other = makeRun(1.0);
+  other.get<Coord::X>()[0] = 0.5;
+  EXPECT_THROW_MSG(
+      accumulator.add(other), std::runtime_error,
+      "Coordinates of datasets do not match. Cannot perform addition");
+}
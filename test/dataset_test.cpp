@@ -3,7 +3,10 @@
 /// @author Simon Heybrock
 /// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
 /// National Laboratory, and European Spallation Source ERIC.
+#include <atomic>
 #include <gtest/gtest.h>
+#include <limits>
+#include <numeric>
 
 #include "test_macros.h"
 
@@ -738,6 +741,419 @@ TEST(Dataset, filter) {
   EXPECT_EQ(filtered.get<const Data::Value>()[3], 8.0);
 }
 
+Dataset makeSpectraForApply() {
+  Dataset d;
+  d.insert<Coord::Tof>({Dim::Tof, 3}, {1.0, 2.0, 3.0});
+  d.insert<Coord::SpectrumNumber>({Dim::Spectrum, 4}, {1, 2, 3, 4});
+  d.insert<Data::Value>(
+      "", {{Dim::Spectrum, 4}, {Dim::Tof, 3}},
+      {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0});
+  return d;
+}
+
+TEST(Dataset, applyOver) {
+  auto d = makeSpectraForApply();
+  const auto original(d);
+
+  // Scale every spectrum by its maximum, in place.
+  applyOver(d, Dim::Spectrum, [](Slice<Dataset> spectrum) {
+    for (auto var : detail::makeAccess(spectrum)) {
+      if (var.type() != tag_id<Data::Value>)
+        continue;
+      auto values = var.get<Data::Value>();
+      const double max = *std::max_element(values.begin(), values.end());
+      for (auto &value : values)
+        value /= max;
+    }
+  });
+
+  const auto values = d.get<const Data::Value>();
+  for (gsl::index i = 0; i < 12; ++i)
+    EXPECT_DOUBLE_EQ(values[i], (i + 1.0) / (3 * (i / 3) + 3.0));
+  // Data shared with other datasets is not modified.
+  EXPECT_EQ(original, makeSpectraForApply());
+  EXPECT_EQ(d.get<const Coord::Tof>(), original.get<const Coord::Tof>());
+}
+
+TEST(Dataset, applyOver_exception) {
+  auto d = makeSpectraForApply();
+  EXPECT_THROW_MSG(applyOver(d, Dim::Spectrum,
+                             [](Slice<Dataset> spectrum) {
+                               const auto value =
+                                   spectrum[1].get<const Data::Value>()[0];
+                               if (value > 5.0)
+                                 throw std::runtime_error(
+                                     std::to_string(value));
+                             }),
+                   std::runtime_error, "7.000000");
+  EXPECT_THROW(applyOver(d, Dim::X, [](Slice<Dataset>) {}),
+               dataset::except::DimensionNotFoundError);
+}
+
+TEST(Dataset, applyOver_exception_lowest_index) {
+  Dataset d;
+  d.insert<Data::Value>("", {Dim::Spectrum, 1000});
+  auto values = d.get<Data::Value>();
+  std::iota(values.begin(), values.end(), 0.0);
+  std::atomic<gsl::index> processed{0};
+  // Every slice from 500 on throws, slices before are all processed.
+  EXPECT_THROW_MSG(applyOver(d, Dim::Spectrum,
+                             [&processed](Slice<Dataset> spectrum) {
+                               const auto value =
+                                   spectrum[0].get<const Data::Value>()[0];
+                               if (value >= 500.0)
+                                 throw std::runtime_error(
+                                     std::to_string(value));
+                               ++processed;
+                             }),
+                   std::runtime_error, "500.000000");
+  EXPECT_EQ(processed, 500);
+}
+
+Dataset makeEvents(const std::initializer_list<double> pulseTimes) {
+  Dataset events;
+  std::vector<double> tofs(pulseTimes.size());
+  std::iota(tofs.begin(), tofs.end(), 0.0);
+  events.insert<Data::Tof>("", {Dim::Event, gsl::index(tofs.size())},
+                           tofs.begin(), tofs.end());
+  events.insert<Data::PulseTime>("", {Dim::Event, gsl::index(tofs.size())},
+                                 pulseTimes);
+  return events;
+}
+
+TEST(Dataset, splitEvents) {
+  Dataset d;
+  d.insert<Coord::SpectrumNumber>({Dim::Spectrum, 2}, {1, 2});
+  // Sorted and unsorted pulse times take different code paths.
+  d.insert<Data::Events>("", {Dim::Spectrum, 2},
+                         {makeEvents({0.5, 1.0, 1.5, 2.0, 3.5}),
+                          makeEvents({3.0, 0.0, 1.2, 2.5})});
+  const auto intervals = makeVariable<Coord::TimeInterval>(
+      {Dim::Time, 3}, {std::pair<int64_t, int64_t>{0, 1},
+                       std::pair<int64_t, int64_t>{1, 2},
+                       std::pair<int64_t, int64_t>{3, 5}});
+
+  const auto split = splitEvents(d, intervals);
+
+  EXPECT_EQ(split.get<const Coord::TimeInterval>().size(), 3);
+  EXPECT_EQ(split.get<const Coord::SpectrumNumber>().size(), 2);
+  const auto lists = split.get<const Data::Events>();
+  ASSERT_EQ(lists.size(), 6);
+  // Outer dimension is the interval, inner the spectrum.
+  EXPECT_TRUE(equals(lists[0].get<const Data::PulseTime>(), {0.5}));
+  EXPECT_TRUE(equals(lists[0].get<const Data::Tof>(), {0.0}));
+  EXPECT_TRUE(equals(lists[1].get<const Data::PulseTime>(), {0.0}));
+  EXPECT_TRUE(equals(lists[2].get<const Data::PulseTime>(), {1.0, 1.5}));
+  EXPECT_TRUE(equals(lists[2].get<const Data::Tof>(), {1.0, 2.0}));
+  EXPECT_TRUE(equals(lists[3].get<const Data::PulseTime>(), {1.2}));
+  EXPECT_TRUE(equals(lists[4].get<const Data::PulseTime>(), {3.5}));
+  EXPECT_TRUE(equals(lists[5].get<const Data::PulseTime>(), {3.0}));
+  EXPECT_TRUE(equals(lists[5].get<const Data::Tof>(), {0.0}));
+}
+
+TEST(Dataset, splitEvents_fail) {
+  Dataset d;
+  d.insert<Data::Events>("", {Dim::Spectrum, 1}, {makeEvents({1.0})});
+  EXPECT_THROW_MSG(
+      splitEvents(d, makeVariable<Coord::TimeInterval>(
+                         {Dim::Time, 2}, {std::pair<int64_t, int64_t>{0, 2},
+                                          std::pair<int64_t, int64_t>{1, 3}})),
+      std::runtime_error,
+      "Cannot split events: Intervals must be sorted and must not overlap.");
+  EXPECT_THROW_MSG(
+      splitEvents(d, makeVariable<Coord::TimeInterval>(
+                         {Dim::Spectrum, 1},
+                         {std::pair<int64_t, int64_t>{0, 2}})),
+      std::runtime_error,
+      "Cannot split events: Dataset already contains the dimension of the "
+      "intervals.");
+}
+
+TEST(Dataset, binEvents) {
+  Dataset d;
+  d.insert<Coord::SpectrumNumber>({Dim::Spectrum, 2}, {1, 2});
+  d.insert<Data::Events>("", {Dim::Spectrum, 2},
+                         {makeEvents({0.5, 1.0, 1.5, 2.0, 3.5}),
+                          makeEvents({3.0, 0.0, 1.2, 2.5})});
+  const EventCoordinate tof = [](const Dataset &events, const gsl::index,
+                                 gsl::span<double> out) {
+    const auto tofs = events.get<const Data::Tof>();
+    std::copy(tofs.begin(), tofs.end(), out.begin());
+  };
+  // Coordinates can depend on the index of the event list, e.g., for
+  // computing Q from detector positions.
+  const EventCoordinate x = [](const Dataset &events, const gsl::index i,
+                               gsl::span<double> out) {
+    const auto times = events.get<const Data::PulseTime>();
+    for (gsl::index event = 0; event < times.size(); ++event)
+      out[event] = times[event] + i;
+  };
+  // Progressions and explicit edges take different code paths.
+  const auto tofEdges =
+      makeArithmeticProgression<Coord::Tof>(Dim::Tof, 3, 0.0, 2.0);
+  const auto xEdges = makeVariable<Coord::X>({Dim::X, 3}, {0.0, 1.0, 3.0});
+
+  const auto binned = binEvents(d, {tof, x}, {tofEdges, xEdges});
+
+  EXPECT_EQ(binned.get<const Coord::Tof>().size(), 3);
+  EXPECT_EQ(binned.get<const Coord::X>().size(), 3);
+  EXPECT_EQ(binned[2].dimensions(), (Dimensions{{Dim::Tof, 2}, {Dim::X, 2}}));
+  // Events outside the edges in any dimension are ignored.
+  EXPECT_TRUE(equals(binned.get<const Data::Value>(), {1.0, 2.0, 0.0, 3.0}));
+}
+
+TEST(Dataset, binEvents_non_finite) {
+  const auto nan = std::numeric_limits<double>::quiet_NaN();
+  const auto inf = std::numeric_limits<double>::infinity();
+  Dataset d;
+  d.insert<Data::Events>("", {Dim::Spectrum, 1},
+                         {makeEvents({nan, 0.5, -inf, 1e300, inf, -1e300})});
+  const EventCoordinate time = [](const Dataset &events, const gsl::index,
+                                  gsl::span<double> out) {
+    const auto times = events.get<const Data::PulseTime>();
+    std::copy(times.begin(), times.end(), out.begin());
+  };
+
+  for (const auto &edges :
+       {makeArithmeticProgression<Coord::Tof>(Dim::Tof, 3, 0.0, 1.0),
+        makeGeometricProgression<Coord::Tof>(Dim::Tof, 3, 0.5, 2.0),
+        makeVariable<Coord::Tof>({Dim::Tof, 3}, {0.0, 1.0, 2.0})}) {
+    const auto binned = binEvents(d, {time}, {edges});
+    EXPECT_TRUE(equals(binned.get<const Data::Value>(), {1.0, 0.0}));
+  }
+}
+
+TEST(Dataset, binEvents_fail) {
+  Dataset d;
+  d.insert<Data::Events>("", {Dim::Spectrum, 1}, {makeEvents({1.0})});
+  const EventCoordinate tof = [](const Dataset &events, const gsl::index,
+                                 gsl::span<double> out) {
+    const auto tofs = events.get<const Data::Tof>();
+    std::copy(tofs.begin(), tofs.end(), out.begin());
+  };
+  const auto edges = makeVariable<Coord::X>({Dim::X, 3}, {0.0, 1.0, 3.0});
+
+  EXPECT_THROW_MSG(binEvents(d, {tof, tof}, {edges}), std::runtime_error,
+                   "Cannot bin events: Require one set of bin edges for each "
+                   "event coordinate.");
+  EXPECT_THROW_MSG(binEvents(d, {tof, tof}, {edges, edges}),
+                   std::runtime_error,
+                   "Cannot bin events: Bin edges must have distinct "
+                   "dimensions.");
+  EXPECT_THROW_MSG(
+      binEvents(d, {tof},
+                {makeVariable<Coord::X>({Dim::X, 3}, {0.0, 2.0, 1.0})}),
+      std::runtime_error, "Cannot bin events: Bin edges must be sorted.");
+  EXPECT_THROW_MSG(
+      binEvents(d, {tof}, {makeVariable<Coord::X>({Dim::X, 1}, {0.0})}),
+      std::runtime_error,
+      "Cannot bin events: Bin edges must be 1-dimensional with at least two "
+      "values.");
+  EXPECT_THROW_MSG(binEvents(Dataset{}, {tof}, {edges}), std::runtime_error,
+                   "Cannot bin events: Dataset does not contain an event "
+                   "variable.");
+}
+
+TEST(Dataset, integrate) {
+  Dataset d;
+  d.insert<Coord::X>({Dim::X, 5}, {0.0, 1.0, 2.0, 3.0, 4.0});
+  d.insert<Coord::Y>({Dim::Y, 2}, {1.0, 2.0});
+  d.insert<Data::Value>("", {{Dim::Y, 2}, {Dim::X, 4}},
+                        {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+  d.insert<Data::Variance>("", {{Dim::Y, 2}, {Dim::X, 4}},
+                           {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+
+  auto integrated = integrate(d, Dim::X, 0.5, 2.25);
+
+  EXPECT_FALSE(integrated.contains(tag<Coord::X>));
+  EXPECT_EQ(integrated.dimensions(), Dimensions(Dim::Y, 2));
+  const auto values = integrated.get<const Data::Value>();
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_DOUBLE_EQ(values[0], 0.5 * 1.0 + 2.0 + 0.25 * 3.0);
+  EXPECT_DOUBLE_EQ(values[1], 0.5 * 5.0 + 6.0 + 0.25 * 7.0);
+  const auto variances = integrated.get<const Data::Variance>();
+  EXPECT_DOUBLE_EQ(variances[0], 0.25 * 1.0 + 2.0 + 0.0625 * 3.0);
+  EXPECT_DOUBLE_EQ(variances[1], 0.25 * 5.0 + 6.0 + 0.0625 * 7.0);
+}
+
+TEST(Dataset, integrate_outer_dimension) {
+  Dataset d;
+  d.insert<Coord::Y>({Dim::Y, 3}, {0.0, 1.0, 2.0});
+  d.insert<Data::Value>("", {{Dim::Y, 2}, {Dim::X, 2}}, {1.0, 2.0, 3.0, 4.0});
+
+  auto integrated = integrate(d, Dim::Y, -1.0, 10.0);
+  EXPECT_TRUE(equals(integrated.get<const Data::Value>(), {4.0, 6.0}));
+}
+
+TEST(Dataset, integrate_zero_extent) {
+  Dataset d;
+  d.insert<Coord::Y>({Dim::Y, 4}, {0.0, 1.0, 2.0, 3.0});
+  d.insert<Data::Value>("", {{Dim::Y, 3}, {Dim::X, 0}});
+  d.insert<Data::Variance>("", {{Dim::Y, 3}, {Dim::X, 0}});
+
+  auto integrated = integrate(d, Dim::Y, 0.5, 2.5);
+  EXPECT_EQ(integrated.get<const Data::Value>().size(), 0);
+  EXPECT_EQ(integrated.get<const Data::Variance>().size(), 0);
+}
+
+TEST(Dataset, integrate_sparse) {
+  Dataset d;
+  d.insert<Coord::X>({Dim::X, 5}, {0.0, 1.0, 2.0, 3.0, 4.0});
+  auto values = makeVariable<Data::Value>(
+      {{Dim::Y, 2}, {Dim::X, 4}}, {0.0, 2.0, 0.0, 0.0, 0.0, 0.0, 4.0, 1.0});
+  values.makeSparse();
+  d.insert(values);
+
+  auto integrated = integrate(d, Dim::X, 0.5, 2.25);
+  EXPECT_TRUE(equals(integrated.get<const Data::Value>(), {2.0, 1.0}));
+}
+
+TEST(Dataset, times_equals_constant_variance) {
+  Dataset a;
+  a.insert<Data::Value>("", {Dim::X, 2}, {2.0, 3.0});
+  a.insert(makeConstantVariable<Data::Variance>({Dim::X, 2}, 0.0));
+  Dataset b;
+  b.insert<Data::Value>("", {Dim::X, 2}, {2.0, 3.0});
+  b.insert<Data::Variance>("", {Dim::X, 2}, {1.0, 2.0});
+
+  a *= b;
+  EXPECT_TRUE(equals(a.get<const Data::Value>(), {4.0, 9.0}));
+  EXPECT_TRUE(equals(a.get<const Data::Variance>(), {4.0, 18.0}));
+}
+
+TEST(Dataset, sort_constant_variance) {
+  Dataset d;
+  d.insert<Coord::X>({Dim::X, 3}, {3.0, 1.0, 2.0});
+  d.insert<Data::Value>("", {Dim::X, 3}, {1.0, 2.0, 3.0});
+  d.insert(makeConstantVariable<Data::Variance>({Dim::X, 3}, 0.5));
+
+  const auto sorted = sort(d, tag<Coord::X>);
+  EXPECT_TRUE(equals(sorted.get<const Data::Value>(), {2.0, 3.0, 1.0}));
+  EXPECT_EQ(sorted[sorted.find(tag_id<Data::Variance>, "")],
+            makeConstantVariable<Data::Variance>({Dim::X, 3}, 0.5));
+}
+
+TEST(Dataset, integrate_progression) {
+  Dataset d;
+  d.insert(makeArithmeticProgression<Coord::X>(Dim::X, 5, 0.0, 1.0));
+  d.insert<Data::Value>("", {Dim::X, 4}, {1.0, 2.0, 3.0, 4.0});
+
+  auto integrated = integrate(d, Dim::X, 0.5, 2.25);
+  EXPECT_TRUE(
+      equals(integrated.get<const Data::Value>(), {0.5 + 2.0 + 0.25 * 3.0}));
+}
+
+TEST(Dataset, integrate_progression_infinite_range) {
+  Dataset d;
+  d.insert(makeArithmeticProgression<Coord::X>(Dim::X, 5, 0.0, 1.0));
+  d.insert<Data::Value>("", {Dim::X, 4}, {1.0, 2.0, 3.0, 4.0});
+  const double inf = std::numeric_limits<double>::infinity();
+  auto integrated = integrate(d, Dim::X, -inf, inf);
+  EXPECT_TRUE(equals(integrated.get<const Data::Value>(), {10.0}));
+}
+
+TEST(Dataset, integrate_fail) {
+  Dataset d;
+  d.insert<Data::Value>("", {Dim::X, 2}, {1.0, 2.0});
+  EXPECT_THROW_MSG(
+      integrate(d, Dim::X, 0.0, 1.0), std::runtime_error,
+      "Cannot integrate: Dataset lacks a coordinate for this dimension.");
+  d.insert<Coord::X>({Dim::X, 2}, {0.0, 1.0});
+  EXPECT_THROW_MSG(integrate(d, Dim::X, 0.0, 1.0), std::runtime_error,
+                   "Cannot integrate: Coordinate must be a 1-dimensional "
+                   "bin-edge coordinate.");
+}
+
+TEST(Dataset, normalizeByMonitor) {
+  Dataset d;
+  d.insert<Coord::Tof>({Dim::Tof, 3}, {0.0, 2.0, 4.0});
+  d.insert<Coord::MonitorTof>({Dim::MonitorTof, 5}, {0.0, 1.0, 2.0, 3.0, 4.0});
+  d.insert<Data::Value>("monitor", {Dim::MonitorTof, 4}, {1.0, 2.0, 3.0, 4.0});
+  d.insert<Data::Variance>("monitor", {Dim::MonitorTof, 4},
+                           {1.0, 1.0, 1.0, 1.0});
+  d.insert<Data::Value>("sample", {{Dim::Spectrum, 2}, {Dim::Tof, 2}},
+                        {3.0, 7.0, 6.0, 14.0});
+  d.insert<Data::Variance>("sample", {{Dim::Spectrum, 2}, {Dim::Tof, 2}},
+                           {1.0, 2.0, 3.0, 4.0});
+
+  const auto normalized = normalizeByMonitor(d, "monitor");
+
+  // Rebinned monitor is {3, 7} with variances {2, 2}.
+  EXPECT_TRUE(equals(normalized.get<const Data::Value>("sample"),
+                     {1.0, 1.0, 2.0, 2.0}));
+  const auto variances = normalized.get<const Data::Variance>("sample");
+  EXPECT_DOUBLE_EQ(variances[0], 3.0 / 9.0);
+  EXPECT_DOUBLE_EQ(variances[1], 4.0 / 49.0);
+  EXPECT_DOUBLE_EQ(variances[2], 11.0 / 9.0);
+  EXPECT_DOUBLE_EQ(variances[3], 12.0 / 49.0);
+  EXPECT_EQ(normalized.get<const Data::Value>("monitor"),
+            d.get<const Data::Value>("monitor"));
+}
+
+TEST(Dataset, normalizeByMonitor_partial_overlap) {
+  Dataset d;
+  d.insert<Coord::Tof>({Dim::Tof, 3}, {0.0, 1.5, 4.0});
+  d.insert<Coord::MonitorTof>({Dim::MonitorTof, 5}, {0.0, 1.0, 2.0, 3.0, 4.0});
+  d.insert<Data::Value>("monitor", {Dim::MonitorTof, 4}, {1.0, 2.0, 3.0, 4.0});
+  // Tof is the outer dimension.
+  d.insert<Data::Value>("sample", {{Dim::Tof, 2}, {Dim::Spectrum, 2}},
+                        {2.0, 4.0, 8.0, 16.0});
+
+  const auto normalized = normalizeByMonitor(d, "monitor");
+
+  // Rebinned monitor is {2, 8}.
+  EXPECT_TRUE(equals(normalized.get<const Data::Value>("sample"),
+                     {1.0, 2.0, 1.0, 2.0}));
+}
+
+TEST(Dataset, normalizeByMonitor_zero_extent) {
+  for (const auto &dims :
+       {Dimensions{{Dim::Tof, 0}, {Dim::Spectrum, 2}},
+        Dimensions{{Dim::Tof, 2}, {Dim::Spectrum, 0}}}) {
+    Dataset d;
+    const auto tofSize = dims.size(Dim::Tof);
+    const std::vector<double> edges{0.0, 1.0, 2.0};
+    d.insert<Coord::Tof>({Dim::Tof, tofSize + 1}, edges.begin(),
+                         edges.begin() + tofSize + 1);
+    d.insert<Coord::MonitorTof>({Dim::MonitorTof, 3}, {0.0, 1.0, 2.0});
+    d.insert<Data::Value>("monitor", {Dim::MonitorTof, 2}, {1.0, 2.0});
+    d.insert<Data::Variance>("monitor", {Dim::MonitorTof, 2}, {1.0, 1.0});
+    d.insert<Data::Value>("sample", dims);
+    d.insert<Data::Variance>("sample", dims);
+
+    const auto normalized = normalizeByMonitor(d, "monitor");
+
+    EXPECT_EQ(normalized.get<const Data::Value>("sample").size(), 0);
+    EXPECT_EQ(normalized.get<const Data::Variance>("sample").size(), 0);
+  }
+}
+
+TEST(Dataset, normalizeByMonitor_fail) {
+  Dataset d;
+  d.insert<Coord::Tof>({Dim::Tof, 2}, {0.0, 2.0});
+  d.insert<Coord::MonitorTof>({Dim::MonitorTof, 2}, {0.0, 2.0});
+  d.insert<Data::Value>("monitor", {{Dim::Monitor, 1}, {Dim::MonitorTof, 1}},
+                        {1.0});
+  d.insert<Data::Value>("sample", {Dim::Tof, 1}, {1.0});
+  EXPECT_THROW_MSG(normalizeByMonitor(d, "monitor"), std::runtime_error,
+                   "Cannot normalize: Monitor must be 1-dimensional along "
+                   "Dim::MonitorTof.");
+}
+
+TEST(Dataset, normalizeByMonitor_monitor_range_fail) {
+  for (const auto &monitorEdges :
+       {std::vector<double>{0.5, 2.0}, std::vector<double>{0.0, 1.5}}) {
+    Dataset d;
+    d.insert<Coord::Tof>({Dim::Tof, 2}, {0.0, 2.0});
+    d.insert<Coord::MonitorTof>({Dim::MonitorTof, 2}, monitorEdges);
+    d.insert<Data::Value>("monitor", {Dim::MonitorTof, 1}, {1.0});
+    d.insert<Data::Value>("sample", {Dim::Tof, 1}, {1.0});
+    EXPECT_THROW_MSG(normalizeByMonitor(d, "monitor"), std::runtime_error,
+                     "Cannot normalize: Monitor bin edges must cover the Tof "
+                     "range of the data.");
+  }
+}
+
 TEST(DatasetSlice, basics) {
   Dataset d;
   d.insert<Coord::X>({Dim::X, 4});
@@ -0,0 +1,104 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <numeric>
+
+#include <omp.h>
+
+#include "test_macros.h"
+
+#include "dataset_view_algorithm.h"
+
+Dataset makeMixedDimensions() {
+  // More items than a single chunk, with a partial last chunk.
+  Dataset d;
+  d.insert<Data::Variance>("", {Dim::Spectrum, 7});
+  d.insert<Data::Value>("", {{Dim::Spectrum, 7}, {Dim::Tof, 1001}});
+  auto variances = d.get<Data::Variance>();
+  for (gsl::index i = 0; i < variances.size(); ++i)
+    variances[i] = 0.5 + i;
+  auto values = d.get<Data::Value>();
+  for (gsl::index i = 0; i < values.size(); ++i)
+    values[i] = 1.0 / (1.0 + i);
+  return d;
+}
+
+TEST(DatasetViewAlgorithm, transformReduce) {
+  const auto d = makeMixedDimensions();
+  DatasetView<const Data::Value, const Data::Variance> view(d);
+  const auto chiSquare = [](const auto &item) {
+    return item.value() * item.value() / item.variance();
+  };
+
+  double expected = 0.0;
+  for (const auto &item : view)
+    expected += chiSquare(item);
+  const auto result = transformReduce(view, 0.0, std::plus<>(), chiSquare);
+  // Summation order differs from the serial loop.
+  EXPECT_NEAR(result, expected, 1e-12 * expected);
+
+  // Identical result independent of the number of threads.
+  const auto threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  const auto serial = transformReduce(view, 0.0, std::plus<>(), chiSquare);
+  omp_set_num_threads(threads);
+  EXPECT_EQ(result, serial);
+}
+
+TEST(DatasetViewAlgorithm, transformReduce_init) {
+  const auto d = makeMixedDimensions();
+  DatasetView<const Data::Value> view(d);
+  EXPECT_EQ(transformReduce(view, gsl::index{10}, std::plus<>(),
+                            [](const auto &) { return gsl::index{1}; }),
+            10 + 7 * 1001);
+  EXPECT_EQ(transformReduce(
+                view, 2.0,
+                [](const double a, const double b) { return std::max(a, b); },
+                [](const auto &item) { return item.value(); }),
+            2.0);
+}
+
+TEST(DatasetViewAlgorithm, forEach) {
+  auto d = makeMixedDimensions();
+  const auto original(d);
+  DatasetView<Data::Value, const Data::Variance> view(d);
+  forEach(view, [](const auto &item) { item.value() -= item.variance(); });
+
+  const auto values = d.get<const Data::Value>();
+  const auto originalValues = original.get<const Data::Value>();
+  const auto variances = d.get<const Data::Variance>();
+  for (gsl::index i = 0; i < values.size(); ++i)
+    EXPECT_EQ(values[i], originalValues[i] - variances[i / 1001]);
+}
+
+TEST(DatasetViewAlgorithm, exception) {
+  const auto d = makeMixedDimensions();
+  DatasetView<const Data::Value> view(d);
+  EXPECT_THROW_MSG(forEach(view,
+                           [](const auto &item) {
+                             if (item.value() < 1.0 / 5000.0)
+                               throw std::runtime_error("small");
+                           }),
+                   std::runtime_error, "small");
+}
+
+TEST(DatasetViewAlgorithm, exception_lowest_index) {
+  Dataset d;
+  d.insert<Data::Value>("", {Dim::X, 100000});
+  auto values = d.get<Data::Value>();
+  std::iota(values.begin(), values.end(), 0.0);
+  DatasetView<const Data::Value> view(d);
+  // Items in many different chunks throw different messages.
+  EXPECT_THROW_MSG(forEach(view,
+                           [](const auto &item) {
+                             if (item.value() >= 9000.0)
+                               throw std::runtime_error(
+                                   std::to_string(item.value()));
+                           }),
+                   std::runtime_error, "9000.000000");
+}
@@ -0,0 +1,126 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+
+#include "test_macros.h"
+
+#include "event_box_tree.h"
+
+std::vector<std::vector<double>> makeColumns(const gsl::index ndim,
+                                             const gsl::index size) {
+  std::mt19937 gen(42);
+  // Clustered data, such that boxes are split to different depths.
+  std::normal_distribution<double> dist(0.0, 1.0);
+  std::vector<std::vector<double>> columns(ndim);
+  for (auto &column : columns)
+    for (gsl::index i = 0; i < size; ++i)
+      column.push_back(dist(gen));
+  return columns;
+}
+
+std::vector<gsl::span<const double>>
+makeSpans(const std::vector<std::vector<double>> &columns) {
+  std::vector<gsl::span<const double>> spans;
+  for (const auto &column : columns)
+    spans.emplace_back(column);
+  return spans;
+}
+
+TEST(EventBoxTree, construct) {
+  const auto columns = makeColumns(3, 10000);
+  EventBoxTree tree({Dim::X, Dim::Y, Dim::Z}, makeSpans(columns), 100);
+  EXPECT_EQ(tree.size(), 10000);
+  EXPECT_GT(tree.boxCount(), 1);
+  EXPECT_EQ(tree.count({{-10.0, 10.0}, {-10.0, 10.0}, {-10.0, 10.0}}), 10000);
+}
+
+TEST(EventBoxTree, construct_fail) {
+  const auto columns = makeColumns(2, 10);
+  EXPECT_THROW_MSG(EventBoxTree({Dim::X}, makeSpans(columns)),
+                   std::runtime_error,
+                   "EventBoxTree: Require one column of coordinates per "
+                   "dimension.");
+  EXPECT_THROW_MSG(EventBoxTree({Dim::X, Dim::Y}, makeSpans(columns), 0),
+                   std::runtime_error,
+                   "EventBoxTree: Split threshold must be positive.");
+}
+
+TEST(EventBoxTree, count) {
+  const auto columns = makeColumns(3, 10000);
+  EventBoxTree tree({Dim::X, Dim::Y, Dim::Z}, makeSpans(columns), 100);
+  const std::vector<std::pair<double, double>> region{
+      {-0.5, 1.0}, {0.2, 2.0}, {-3.0, 0.1}};
+  gsl::index expected = 0;
+  for (gsl::index i = 0; i < 10000; ++i) {
+    bool inside = true;
+    for (gsl::index dim = 0; dim < 3; ++dim)
+      inside &= columns[dim][i] >= region[dim].first &&
+                columns[dim][i] < region[dim].second;
+    expected += inside;
+  }
+  EXPECT_EQ(tree.count(region), expected);
+}
+
+TEST(EventBoxTree, bin) {
+  const auto columns = makeColumns(3, 10000);
+  EventBoxTree tree({Dim::X, Dim::Y, Dim::Z}, makeSpans(columns), 100);
+  // Progressions and explicit edges, the Z dimension is summed over.
+  const auto xEdges =
+      makeArithmeticProgression<Coord::X>(Dim::X, 5, -1.0, 0.5);
+  const auto yEdges =
+      makeVariable<Coord::Y>({Dim::Y, 4}, {-2.0, -0.3, 0.0, 1.7});
+
+  const auto binned = tree.bin({yEdges, xEdges});
+
+  EXPECT_EQ(binned[2].dimensions(), (Dimensions{{Dim::Y, 3}, {Dim::X, 4}}));
+  std::vector<double> expected(12, 0.0);
+  const std::vector<double> x{-1.0, -0.5, 0.0, 0.5, 1.0};
+  const std::vector<double> y{-2.0, -0.3, 0.0, 1.7};
+  for (gsl::index i = 0; i < 10000; ++i) {
+    const auto ix =
+        std::upper_bound(x.begin(), x.end(), columns[0][i]) - x.begin() - 1;
+    const auto iy =
+        std::upper_bound(y.begin(), y.end(), columns[1][i]) - y.begin() - 1;
+    if (ix >= 0 && ix < 4 && iy >= 0 && iy < 3)
+      expected[iy * 4 + ix] += 1.0;
+  }
+  const auto counts = binned.get<const Data::Value>();
+  for (gsl::index i = 0; i < 12; ++i)
+    EXPECT_EQ(counts[i], expected[i]);
+}
+
+TEST(EventBoxTree, non_finite) {
+  auto columns = makeColumns(2, 1000);
+  const auto inf = std::numeric_limits<double>::infinity();
+  columns[0][3] = std::numeric_limits<double>::quiet_NaN();
+  columns[1][4] = inf;
+  columns[0][5] = -inf;
+  columns[1][6] = 1e300;
+  columns[0][7] = -1e300;
+  EventBoxTree tree({Dim::X, Dim::Y}, makeSpans(columns), 10);
+  EXPECT_EQ(tree.size(), 997);
+  EXPECT_EQ(tree.count({{-10.0, 10.0}, {-10.0, 10.0}}), 995);
+  EXPECT_EQ(tree.count({{-inf, inf}, {-inf, inf}}), 997);
+
+  // A single bin covering all finite events that are not huge, such that
+  // boxes are added as a whole.
+  const auto binned =
+      tree.bin({makeVariable<Coord::X>({Dim::X, 2}, {-10.0, 10.0}),
+                makeVariable<Coord::Y>({Dim::Y, 2}, {-10.0, 10.0})});
+  EXPECT_TRUE(equals(binned.get<const Data::Value>(), {995.0}));
+}
+
+TEST(EventBoxTree, bin_fail) {
+  const auto columns = makeColumns(2, 10);
+  EventBoxTree tree({Dim::X, Dim::Y}, makeSpans(columns));
+  EXPECT_THROW_MSG(
+      tree.bin({makeVariable<Coord::Z>({Dim::Z, 2}, {0.0, 1.0})}),
+      std::runtime_error,
+      "EventBoxTree: Bin edges must be along a dimension of the tree.");
+}
@@ -0,0 +1,85 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "test_macros.h"
+
+#include "fft.h"
+
+namespace {
+constexpr double pi = 3.14159265358979323846;
+
+std::vector<std::complex<double>> dft(const std::vector<double> &x) {
+  const gsl::index n = x.size();
+  std::vector<std::complex<double>> result(n);
+  for (gsl::index k = 0; k < n; ++k)
+    for (gsl::index j = 0; j < n; ++j)
+      result[k] += x[j] * std::polar(1.0, -2.0 * pi * j * k / n);
+  return result;
+}
+
+void expectNear(const std::complex<double> &a, const std::complex<double> &b) {
+  EXPECT_NEAR(a.real(), b.real(), 1e-9);
+  EXPECT_NEAR(a.imag(), b.imag(), 1e-9);
+}
+} // namespace
+
+TEST(FFT, plan_cache) {
+  EXPECT_EQ(FFTPlan::get(12), FFTPlan::get(12));
+  EXPECT_NE(FFTPlan::get(12), FFTPlan::get(16));
+  EXPECT_EQ(FFTPlan::get(12)->size(), 12);
+}
+
+TEST(FFT, matches_dft) {
+  for (const gsl::index n : {1, 2, 7, 8, 12, 100}) {
+    std::vector<double> x(n);
+    for (gsl::index i = 0; i < n; ++i)
+      x[i] = std::sin(0.3 * i) + 0.1 * i;
+    const auto var =
+        makeVariable<Data::Value>({Dim::Tof, n}, x.begin(), x.end());
+    const auto result = fft(var, Dim::Tof);
+    const auto expected = dft(x);
+    const auto values = result.get<const Data::Complex>();
+    for (gsl::index k = 0; k < n; ++k)
+      expectNear(values[k], expected[k]);
+  }
+}
+
+TEST(FFT, roundtrip_outer_dimension) {
+  const auto var = makeVariable<Data::Value>(
+      {{Dim::X, 6}, {Dim::Y, 3}}, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0,
+                                   1.0, 0.0, 1.0, 0.0, 1.0, 0.0, 2.0, 4.0,
+                                   8.0});
+  const auto transformed = fft(var, Dim::X);
+  // Transform of strided lines matches transform of a single contiguous line.
+  const auto column = fft(slice(var, Dim::Y, 1), Dim::X);
+  for (gsl::index i = 0; i < 6; ++i)
+    expectNear(transformed.get<const Data::Complex>()[3 * i + 1],
+               column.get<const Data::Complex>()[i]);
+  const auto back = ifft(transformed, Dim::X);
+  const auto values = var.get<const Data::Value>();
+  for (gsl::index i = 0; i < values.size(); ++i)
+    expectNear(back.get<const Data::Complex>()[i], values[i]);
+}
+
+TEST(FFT, constant) {
+  // The transform of a constant is a peak at frequency 0.
+  const auto var = makeConstantVariable<Data::Value>({Dim::X, 4}, 2.0);
+  const auto transformed = fft(var, Dim::X);
+  const auto values = transformed.get<const Data::Complex>();
+  expectNear(values[0], 8.0);
+  for (gsl::index k = 1; k < 4; ++k)
+    expectNear(values[k], 0.0);
+}
+
+TEST(FFT, fail) {
+  const auto var = makeVariable<Data::Value>({Dim::X, 2}, {1.0, 2.0});
+  EXPECT_THROW(fft(var, Dim::Y), dataset::except::DimensionNotFoundError);
+  EXPECT_THROW_MSG(ifft(var, Dim::X), std::runtime_error,
+                   "Cannot compute inverse FFT: Input must be Data::Complex.");
+}
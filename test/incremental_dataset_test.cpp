@@ -0,0 +1,92 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include "test_macros.h"
+
+#include "incremental_dataset.h"
+
+Dataset makeSpectra() {
+  Dataset d;
+  d.insert<Coord::Tof>({Dim::Tof, 2}, {10.0, 20.0});
+  d.insert<Coord::SpectrumNumber>({Dim::Spectrum, 4}, {1, 2, 3, 4});
+  d.insert<Data::Value>("", {{Dim::Spectrum, 4}, {Dim::Tof, 2}},
+                        {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+  return d;
+}
+
+TEST(IncrementalDataset, construct_fail) {
+  EXPECT_THROW(IncrementalDataset(makeSpectra(), Dim::X),
+               dataset::except::DimensionNotFoundError);
+}
+
+TEST(IncrementalDataset, derived_updates_only_modified_slices) {
+  IncrementalDataset incremental(makeSpectra(), Dim::Spectrum);
+  std::vector<gsl::index> extents;
+  const auto square = incremental.addDerived([&](const Dataset &d) {
+    extents.push_back(d.dimensions()[Dim::Spectrum]);
+    return d * d;
+  });
+  EXPECT_EQ(extents, std::vector<gsl::index>({4}));
+  EXPECT_TRUE(equals(incremental.derived(square).get<const Data::Value>(),
+                     {1.0, 4.0, 9.0, 16.0, 25.0, 36.0, 49.0, 64.0}));
+  EXPECT_EQ(extents, std::vector<gsl::index>({4}));
+
+  auto slice = incremental.slice(1, 2);
+  slice += Dataset(slice);
+  Dataset spectrum;
+  spectrum.insert<Coord::SpectrumNumber>({}, {4});
+  spectrum.insert<Data::Value>("", {Dim::Tof, 2}, {-1.0, -2.0});
+  incremental.setSlice(spectrum, 3);
+
+  const auto &result = incremental.derived(square);
+  EXPECT_EQ(extents, std::vector<gsl::index>({4, 1, 1}));
+  EXPECT_TRUE(equals(result.get<const Data::Value>(),
+                     {1.0, 4.0, 36.0, 64.0, 25.0, 36.0, 1.0, 4.0}));
+}
+
+TEST(IncrementalDataset, adjacent_modifications_are_merged) {
+  IncrementalDataset incremental(makeSpectra(), Dim::Spectrum);
+  std::vector<gsl::index> extents;
+  const auto copy = incremental.addDerived([&](const Dataset &d) {
+    extents.push_back(d.dimensions()[Dim::Spectrum]);
+    return d;
+  });
+  for (const auto &range : {std::pair<gsl::index, gsl::index>{2, 3},
+                             std::pair<gsl::index, gsl::index>{1, 2},
+                             std::pair<gsl::index, gsl::index>{1, 3}}) {
+    auto slice = incremental.slice(range.first, range.second);
+    slice += Dataset(slice);
+  }
+
+  EXPECT_EQ(incremental.derived(copy), incremental.source());
+  EXPECT_EQ(extents, std::vector<gsl::index>({4, 2}));
+}
+
+TEST(IncrementalDataset, failed_operation_keeps_modifications) {
+  IncrementalDataset incremental(makeSpectra(), Dim::Spectrum);
+  bool fail = false;
+  std::vector<gsl::index> extents;
+  const auto copy = incremental.addDerived([&](const Dataset &d) {
+    // Fails for the second modified range only.
+    if (fail && d.get<const Coord::SpectrumNumber>()[0] == 3)
+      throw std::runtime_error("failed");
+    extents.push_back(d.dimensions()[Dim::Spectrum]);
+    return d;
+  });
+  for (const gsl::index index : {0, 2}) {
+    auto slice = incremental.slice(index, index + 1);
+    slice += Dataset(slice);
+  }
+
+  fail = true;
+  EXPECT_THROW_MSG(incremental.derived(copy), std::runtime_error, "failed");
+  EXPECT_EQ(extents, std::vector<gsl::index>({4, 1}));
+  fail = false;
+  EXPECT_EQ(incremental.derived(copy), incremental.source());
+  // Only the failed range is recomputed.
+  EXPECT_EQ(extents, std::vector<gsl::index>({4, 1, 1}));
+}
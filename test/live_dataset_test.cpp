@@ -0,0 +1,83 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "test_macros.h"
+
+#include "live_dataset.h"
+
+Dataset makeHistogram() {
+  Dataset d;
+  d.insert<Coord::Tof>({Dim::Tof, 3}, {1.0, 2.0, 3.0});
+  d.insert<Data::Value>("", {Dim::Tof, 3}, {0.0, 0.0, 0.0});
+  return d;
+}
+
+TEST(LiveDataset, snapshot_is_immutable) {
+  LiveDataset live(makeHistogram());
+  const auto before = live.snapshot();
+  live.update([](Dataset &d) { d.get<Data::Value>()[0] += 1.0; });
+  const auto after = live.snapshot();
+
+  EXPECT_TRUE(equals(before->get<const Data::Value>(), {0.0, 0.0, 0.0}));
+  EXPECT_TRUE(equals(after->get<const Data::Value>(), {1.0, 0.0, 0.0}));
+  // Unmodified variables are shared between versions.
+  EXPECT_EQ(&(*before)[0].data(), &(*after)[0].data());
+  EXPECT_NE(&(*before)[1].data(), &(*after)[1].data());
+}
+
+TEST(LiveDataset, failed_update_is_not_published) {
+  LiveDataset live(makeHistogram());
+  const auto before = live.snapshot();
+  EXPECT_THROW(live.update([](Dataset &d) {
+    d.get<Data::Value>()[0] += 1.0;
+    throw std::runtime_error("failed");
+  }),
+               std::runtime_error);
+  EXPECT_EQ(live.snapshot(), before);
+}
+
+TEST(LiveDataset, publish) {
+  LiveDataset live;
+  EXPECT_EQ(live.snapshot()->size(), 0);
+  live.publish(makeHistogram());
+  EXPECT_EQ(live.snapshot()->size(), 2);
+}
+
+TEST(LiveDataset, concurrent_readers) {
+  LiveDataset live(makeHistogram());
+  std::atomic<bool> done{false};
+  std::atomic<bool> consistent{true};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i)
+    readers.emplace_back([&]() {
+      double last = 0.0;
+      while (!done) {
+        // All bins are incremented together, a reader must never see a
+        // partial update.
+        const auto snapshot = live.snapshot();
+        const auto values = snapshot->get<const Data::Value>();
+        if (values[0] != values[1] || values[0] != values[2] ||
+            values[0] < last)
+          consistent = false;
+        last = values[0];
+      }
+    });
+  for (int i = 0; i < 1000; ++i)
+    live.update([](Dataset &d) {
+      for (auto &value : d.get<Data::Value>())
+        value += 1.0;
+    });
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+  EXPECT_TRUE(consistent);
+  EXPECT_TRUE(equals(live.snapshot()->get<const Data::Value>(),
+                     {1000.0, 1000.0, 1000.0}));
+}
@@ -0,0 +1,80 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <numeric>
+
+#include "test_macros.h"
+
+#include "pipeline.h"
+
+Dataset readSpectra(const gsl::index begin, const gsl::index end) {
+  std::vector<double> values(end - begin);
+  std::iota(values.begin(), values.end(), double(begin));
+  Dataset d;
+  d.insert<Data::Value>("", {Dim::Spectrum, end - begin}, values.begin(),
+                        values.end());
+  return d;
+}
+
+TEST(Pipeline, run) {
+  std::vector<double> result(10, -1.0);
+  std::mutex mutex;
+  gsl::index chunks = 0;
+  Pipeline pipeline(
+      10, readSpectra,
+      [&](const gsl::index begin, const gsl::index end, Dataset d) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++chunks;
+        const auto values = d.get<const Data::Value>();
+        std::copy(values.begin(), values.end(), result.begin() + begin);
+        EXPECT_EQ(values.size(), end - begin);
+      });
+  pipeline.setChunkSize(3).setQueueCapacity(1);
+  pipeline.addStage([](Dataset d) {
+    d.get<Data::Value>()[0] += 100.0;
+    return d;
+  });
+  pipeline.addStage(
+      [](Dataset d) {
+        for (auto &x : d.get<Data::Value>())
+          x *= 2.0;
+        return d;
+      },
+      3);
+  pipeline.run();
+  EXPECT_EQ(chunks, 4);
+  EXPECT_EQ(result, std::vector<double>({200.0, 2.0, 4.0, 206.0, 8.0, 10.0,
+                                         212.0, 14.0, 16.0, 218.0}));
+}
+
+TEST(Pipeline, exception_stops_pipeline) {
+  gsl::index written = 0;
+  Pipeline pipeline(100, readSpectra,
+                    [&](const gsl::index, const gsl::index, Dataset) {
+                      ++written;
+                    });
+  pipeline.addStage([](Dataset d) {
+    if (d.get<const Data::Value>()[0] == 5.0)
+      throw std::runtime_error("Stage failed.");
+    return d;
+  });
+  EXPECT_THROW_MSG(pipeline.run(), std::runtime_error, "Stage failed.");
+  EXPECT_LE(written, 5);
+}
+
+TEST(Pipeline, invalid_configuration) {
+  Pipeline pipeline(1, readSpectra,
+                    [](const gsl::index, const gsl::index, Dataset) {});
+  EXPECT_THROW_MSG(pipeline.setChunkSize(0), std::runtime_error,
+                   "Pipeline: Chunk size must be positive.");
+  EXPECT_THROW_MSG(pipeline.setQueueCapacity(0), std::runtime_error,
+                   "Pipeline: Queue capacity must be positive.");
+  EXPECT_THROW_MSG(pipeline.addStage([](Dataset d) { return d; }, 0),
+                   std::runtime_error,
+                   "Pipeline: A stage requires at least one thread.");
+}
@@ -0,0 +1,70 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include "test_macros.h"
+
+#include "slice_pyramid.h"
+
+Variable makePyramidData() {
+  auto var =
+      makeVariable<Data::Value>({{Dim::X, 5}, {Dim::Tof, 2}, {Dim::Y, 4}});
+  auto values = var.get<Data::Value>();
+  std::iota(values.begin(), values.end(), 0.0);
+  return var;
+}
+
+TEST(SlicePyramid, level) {
+  EXPECT_EQ(SlicePyramid::level(0, 4, 0, 4, 4, 4), 0);
+  EXPECT_EQ(SlicePyramid::level(0, 4, 0, 4, 2, 4), 1);
+  EXPECT_EQ(SlicePyramid::level(0, 5, 0, 4, 2, 4), 2);
+  // Unaligned viewports may require one more pixel.
+  EXPECT_EQ(SlicePyramid::level(1, 3, 0, 1, 1, 1), 2);
+  EXPECT_THROW_MSG(SlicePyramid::level(2, 2, 0, 1, 1, 1), std::runtime_error,
+                   "SlicePyramid: Invalid viewport.");
+}
+
+TEST(SlicePyramid, view_full_resolution) {
+  const auto var = makePyramidData();
+  SlicePyramid pyramid(Dim::Y, Dim::X);
+  const auto view = pyramid.view(var, 1, 3, 2, 4, 4, 4);
+  EXPECT_EQ(view.dimensions(), (Dimensions{{Dim::Y, 2}, {Dim::X, 2}}));
+  // Sum over Tof of values 8 * x + 4 * tof + y.
+  EXPECT_TRUE(equals(view.get<const Data::Value>(),
+                     {2 * 19.0, 2 * 27.0, 2 * 20.0, 2 * 28.0}));
+  EXPECT_EQ(pyramid.levelCount(), 1);
+}
+
+TEST(SlicePyramid, view_downsampled) {
+  const auto var = makePyramidData();
+  SlicePyramid pyramid(Dim::Y, Dim::X);
+  const auto view = pyramid.view(var, 0, 4, 0, 5, 2, 3);
+  EXPECT_EQ(pyramid.levelCount(), 2);
+  EXPECT_EQ(view.dimensions(), (Dimensions{{Dim::Y, 2}, {Dim::X, 3}}));
+  // Projection is 2 * (8 * x + y + 2), blocks of 2 x 2, last X block has
+  // a single column.
+  EXPECT_TRUE(equals(view.get<const Data::Value>(),
+                     {2 * 26.0, 2 * 90.0, 2 * 69.0, 2 * 34.0, 2 * 98.0,
+                      2 * 73.0}));
+  // Levels are reused, the total is preserved at every level.
+  const auto coarse = pyramid.view(var, 0, 4, 0, 5, 1, 1);
+  EXPECT_EQ(pyramid.levelCount(), 4);
+  const auto values = var.get<const Data::Value>();
+  EXPECT_TRUE(equals(coarse.get<const Data::Value>(),
+                     {std::accumulate(values.begin(), values.end(), 0.0)}));
+}
+
+TEST(SlicePyramid, mutation_invalidates_cache) {
+  auto var = makePyramidData();
+  SlicePyramid pyramid(Dim::Y, Dim::X);
+  const auto before = pyramid.view(var, 0, 1, 0, 1, 1, 1);
+  var.get<Data::Value>()[0] += 10.0;
+  const auto after = pyramid.view(var, 0, 1, 0, 1, 1, 1);
+  EXPECT_EQ(after.get<const Data::Value>()[0],
+            before.get<const Data::Value>()[0] + 10.0);
+}
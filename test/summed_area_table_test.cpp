@@ -0,0 +1,59 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include "test_macros.h"
+
+#include "summed_area_table.h"
+
+TEST(SummedAreaTable, sum_1d) {
+  auto var =
+      makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::Tof, 4}},
+                                {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+  SummedAreaTable table(Dim::Tof);
+  auto sum = table.sum(var, 1, 3);
+  EXPECT_EQ(sum.dimensions(), Dimensions(Dim::Y, 2));
+  EXPECT_TRUE(equals(sum.get<const Data::Value>(), {5.0, 13.0}));
+  EXPECT_TRUE(equals(table.sum(var, 0, 4).get<const Data::Value>(),
+                     {10.0, 26.0}));
+  EXPECT_TRUE(
+      equals(table.sum(var, 3, 4).get<const Data::Value>(), {4.0, 8.0}));
+}
+
+TEST(SummedAreaTable, sum_2d) {
+  auto var = makeVariable<Data::Value>(
+      {{Dim::Tof, 2}, {Dim::Y, 3}, {Dim::X, 3}},
+      {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0,
+       10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 70.0, 80.0, 90.0});
+  SummedAreaTable table(Dim::Y, Dim::X);
+  auto sum = table.sum(var, 1, 3, 1, 3);
+  EXPECT_EQ(sum.dimensions(), Dimensions(Dim::Tof, 2));
+  EXPECT_TRUE(equals(sum.get<const Data::Value>(), {28.0, 280.0}));
+  EXPECT_TRUE(equals(table.sum(var, 0, 1, 0, 2).get<const Data::Value>(),
+                     {3.0, 30.0}));
+  EXPECT_TRUE(equals(table.sum(var, 0, 3, 0, 3).get<const Data::Value>(),
+                     {45.0, 450.0}));
+}
+
+TEST(SummedAreaTable, invalidated_by_mutation) {
+  auto var = makeVariable<Data::Value>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  SummedAreaTable table(Dim::X);
+  EXPECT_EQ(table.sum(var, 0, 3).get<const Data::Value>()[0], 6.0);
+  var.get<Data::Value>()[0] = 11.0;
+  EXPECT_EQ(table.sum(var, 0, 3).get<const Data::Value>()[0], 16.0);
+}
+
+TEST(SummedAreaTable, fail) {
+  auto var = makeVariable<Data::Value>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  SummedAreaTable table(Dim::X);
+  EXPECT_THROW_MSG(table.sum(var, 2, 1), std::runtime_error,
+                   "SummedAreaTable: Invalid range.");
+  EXPECT_THROW_MSG(table.sum(var, 0, 4), std::runtime_error,
+                   "SummedAreaTable: Invalid range.");
+  EXPECT_THROW_MSG(table.sum(var, 0, 1, 0, 1), std::runtime_error,
+                   "SummedAreaTable: Table is 1-dimensional, must provide one "
+                   "range.");
+}
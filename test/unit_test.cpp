@@ -53,3 +53,31 @@ TEST(Unit, multiply_counts) {
   EXPECT_EQ(counts * none, counts);
   EXPECT_EQ(none * counts, counts);
 }
+
+TEST(Unit, compare_scale) {
+  Unit m{Unit::Id::Length};
+  Unit mm{Unit::Id::Length, 1e-3};
+  EXPECT_TRUE(m == m);
+  EXPECT_TRUE(m != mm);
+  EXPECT_EQ(mm.scale(), 1e-3);
+}
+
+TEST(Unit, multiply_scale) {
+  Unit m{Unit::Id::Length};
+  Unit mm{Unit::Id::Length, 1e-3};
+  Unit none{Unit::Id::Dimensionless};
+  EXPECT_EQ(mm * none, mm);
+  EXPECT_EQ(none * mm, mm);
+  EXPECT_EQ(mm * m, Unit(Unit::Id::Area, 1e-3));
+  EXPECT_EQ(mm * mm, Unit(Unit::Id::Area, 1e-6));
+  EXPECT_ANY_THROW(m + mm);
+}
+
+TEST(Unit, conversionFactor) {
+  Unit m{Unit::Id::Length};
+  Unit mm{Unit::Id::Length, 1e-3};
+  EXPECT_DOUBLE_EQ(conversionFactor(mm, m), 1e-3);
+  EXPECT_DOUBLE_EQ(conversionFactor(m, mm), 1e3);
+  EXPECT_DOUBLE_EQ(conversionFactor(m, m), 1.0);
+  EXPECT_ANY_THROW(conversionFactor(m, Unit::Id::Area));
+}
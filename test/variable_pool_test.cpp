@@ -0,0 +1,87 @@
+/// @file
+/// SPDX-License-Identifier: GPL-3.0-or-later
+/// @author Simon Heybrock
+/// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
+/// National Laboratory, and European Spallation Source ERIC.
+#include <gtest/gtest.h>
+
+#include "test_macros.h"
+
+#include "dataset.h"
+#include "variable_pool.h"
+
+const VariableConcept &constData(const Variable &var) { return var.data(); }
+
+TEST(VariablePool, intern_shares_identical_data) {
+  auto &pool = VariablePool::instance();
+  auto a = makeVariable<Coord::X>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  auto b = makeVariable<Coord::X>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  auto c = makeVariable<Coord::X>({Dim::X, 3}, {1.0, 2.0, 4.0});
+  pool.intern(a);
+  pool.intern(b);
+  pool.intern(c);
+  EXPECT_EQ(&constData(a), &constData(b));
+  EXPECT_NE(&constData(a), &constData(c));
+  EXPECT_EQ(a, b);
+
+  // Copy-on-write keeps interned data unchanged.
+  b.get<Coord::X>()[0] = 0.0;
+  EXPECT_NE(&constData(a), &constData(b));
+  EXPECT_TRUE(equals(a.get<const Coord::X>(), {1.0, 2.0, 3.0}));
+}
+
+TEST(VariablePool, intern_requires_same_dimensions_and_type) {
+  auto &pool = VariablePool::instance();
+  auto a = makeVariable<Coord::X>({Dim::X, 2}, {5.0, 6.0});
+  auto b = makeVariable<Coord::Y>({Dim::Y, 2}, {5.0, 6.0});
+  auto c = makeVariable<Data::Int>({Dim::X, 4}, {0, 0, 0, 0});
+  auto d = makeVariable<Data::Value>({Dim::X, 2}, {0.0, 0.0});
+  pool.intern(a);
+  pool.intern(b);
+  pool.intern(c);
+  pool.intern(d);
+  EXPECT_NE(&constData(a), &constData(b));
+  EXPECT_NE(&constData(c), &constData(d));
+}
+
+TEST(VariablePool, weak_references) {
+  auto &pool = VariablePool::instance();
+  const auto before = pool.size();
+  {
+    auto a = makeVariable<Coord::X>({Dim::X, 2}, {7.0, 8.0});
+    pool.intern(a);
+    EXPECT_EQ(pool.size(), before + 1);
+  }
+  EXPECT_EQ(pool.size(), before);
+}
+
+TEST(VariablePool, intern_modified_entry) {
+  auto &pool = VariablePool::instance();
+  auto a = makeVariable<Coord::X>({Dim::X, 2}, {9.0, 10.0});
+  pool.intern(a);
+  // `a` is the only owner, so this modifies the registered data in-place.
+  a.get<Coord::X>()[0] = 11.0;
+  auto b = makeVariable<Coord::X>({Dim::X, 2}, {9.0, 10.0});
+  pool.intern(b);
+  EXPECT_NE(&constData(a), &constData(b));
+  EXPECT_TRUE(equals(b.get<const Coord::X>(), {9.0, 10.0}));
+}
+
+TEST(VariablePool, intern_coordinates) {
+  auto &pool = VariablePool::instance();
+  std::vector<Dataset> runs(3);
+  for (auto &run : runs) {
+    run.insert<Coord::SpectrumNumber>({Dim::Spectrum, 3}, {21, 22, 23});
+    run.insert<Data::Value>("", {Dim::Spectrum, 3}, {1.0, 2.0, 3.0});
+    pool.internCoordinates(run);
+  }
+  const auto &spec = runs[0][runs[0].find(tag_id<Coord::SpectrumNumber>, "")];
+  const auto &data = runs[0][runs[0].find(tag_id<Data::Value>, "")];
+  for (gsl::index i = 1; i < static_cast<gsl::index>(runs.size()); ++i) {
+    const auto &run = runs[i];
+    EXPECT_EQ(&constData(spec),
+              &constData(run[run.find(tag_id<Coord::SpectrumNumber>, "")]));
+    EXPECT_NE(&constData(data),
+              &constData(run[run.find(tag_id<Data::Value>, "")]));
+  }
+}
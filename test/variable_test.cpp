@@ -3,7 +3,10 @@
 /// @author Simon Heybrock
 /// Copyright &copy; 2018 ISIS Rutherford Appleton Laboratory, NScD Oak Ridge
 /// National Laboratory, and European Spallation Source ERIC.
+#include <atomic>
 #include <gtest/gtest.h>
+#include <limits>
+#include <numeric>
 #include <vector>
 
 #include "test_macros.h"
@@ -63,6 +66,23 @@ TEST(Variable, copy) {
   EXPECT_EQ(data2[1], 2.2);
 }
 
+TEST(Variable, copy_large) {
+  // Large enough for cloning in parallel on write.
+  auto a1 = makeVariable<Data::Value>(Dimensions(Dimension::Tof, 100000));
+  auto values1 = a1.get<Data::Value>();
+  std::iota(values1.begin(), values1.end(), 0.0);
+  auto a2(a1);
+  auto values2 = a2.get<Data::Value>();
+  EXPECT_NE(values1.data(), values2.data());
+  EXPECT_EQ(a1, a2);
+  values2[0] = -1.0;
+  EXPECT_EQ(values1[0], 0.0);
+  EXPECT_EQ(values2[99999], 99999.0);
+  // New variables are still zero-initialized.
+  const auto zeros = makeVariable<Data::Value>(Dimensions(Dimension::Tof, 2));
+  EXPECT_TRUE(equals(zeros.get<const Data::Value>(), {0.0, 0.0}));
+}
+
 TEST(Variable, operator_equals) {
   const auto a = makeVariable<Data::Value>({Dimension::Tof, 2}, {1.1, 2.2});
   const auto a_copy(a);
@@ -140,6 +160,30 @@ TEST(Variable, operator_plus_equal_different_unit) {
                    "Cannot add Variables: Units do not match.");
 }
 
+TEST(Variable, operator_plus_equal_different_unit_scale) {
+  auto a = makeVariable<Coord::X>({Dimension::X, 2}, {1.0, 2.0});
+  auto b = makeVariable<Coord::X>({Dimension::X, 2}, {10.0, 20.0});
+  b.setUnit(Unit(Unit::Id::Length, 1e-2));
+  EXPECT_NO_THROW(a += b);
+  EXPECT_EQ(a.unit(), Unit::Id::Length);
+  EXPECT_DOUBLE_EQ(a.get<Coord::X>()[0], 1.1);
+  EXPECT_DOUBLE_EQ(a.get<Coord::X>()[1], 2.2);
+  EXPECT_NO_THROW(a -= b);
+  EXPECT_DOUBLE_EQ(a.get<Coord::X>()[0], 1.0);
+  EXPECT_DOUBLE_EQ(a.get<Coord::X>()[1], 2.0);
+}
+
+TEST(Variable, operator_plus_equal_different_unit_scale_integer) {
+  auto a = makeVariable<Data::Int>({Dimension::X, 2}, {1, 2});
+  a.setUnit(Unit::Id::Length);
+  auto b = makeVariable<Data::Int>({Dimension::X, 2}, {10, 20});
+  b.setUnit(Unit(Unit::Id::Length, 1e-2));
+  EXPECT_THROW_MSG(
+      a += b, std::runtime_error,
+      "Cannot apply unit conversion factor to non-floating-point type.");
+  EXPECT_TRUE(equals(a.get<const Data::Int>(), {1, 2}));
+}
+
 TEST(Variable, operator_plus_equal_non_arithmetic_type) {
   auto a = makeVariable<Data::String>({Dimension::X, 1}, {std::string("test")});
   EXPECT_THROW_MSG(a += a, std::runtime_error,
@@ -149,11 +193,39 @@ TEST(Variable, operator_plus_equal_non_arithmetic_type) {
 TEST(Variable, operator_plus_equal_different_variables_different_element_type) {
   auto a = makeVariable<Data::Value>({Dimension::X, 1}, {1.0});
   auto b = makeVariable<Data::Int>({Dimension::X, 1}, {2});
+  EXPECT_NO_THROW(a += b);
+  EXPECT_EQ(a.get<Data::Value>()[0], 3.0);
+  EXPECT_THROW_MSG(b += a, std::runtime_error,
+                   "Cannot apply arithmetic operation to Variables: Underlying "
+                   "data types do not match.");
+  auto s = makeVariable<Data::String>({Dimension::X, 1}, {std::string("a")});
+  EXPECT_THROW_MSG(a += s, std::runtime_error,
+                   "Cannot apply arithmetic operation to Variables: Underlying "
+                   "data types do not match.");
+}
+
+TEST(Variable, operator_plus_equal_mixed_integer_types) {
+  auto a = makeVariable<Coord::SpectrumNumber>({Dimension::X, 1}, {1});
+  auto b = makeVariable<Data::Int>({Dimension::X, 1}, {2});
+  b.setUnit(a.unit());
+  EXPECT_NO_THROW(b += a);
+  EXPECT_EQ(b.get<const Data::Int>()[0], 3);
+  // Narrowing from int64_t to int32_t is rejected.
   EXPECT_THROW_MSG(a += b, std::runtime_error,
                    "Cannot apply arithmetic operation to Variables: Underlying "
                    "data types do not match.");
 }
 
+TEST(Variable, operator_times_equal_mixed_element_type_broadcast) {
+  auto a = makeVariable<Data::Value>({{Dimension::Y, 2}, {Dimension::X, 2}},
+                                     {1.0, 2.0, 3.0, 4.0});
+  auto b = makeVariable<Data::Int>({Dimension::X, 2}, {2, 3});
+  EXPECT_NO_THROW(a *= b);
+  EXPECT_TRUE(equals(a.get<Data::Value>(), {2.0, 6.0, 6.0, 12.0}));
+  EXPECT_NO_THROW(a -= b);
+  EXPECT_TRUE(equals(a.get<Data::Value>(), {0.0, 3.0, 4.0, 9.0}));
+}
+
 TEST(Variable, operator_plus_equal_different_variables_same_element_type) {
   auto a = makeVariable<Data::Value>({Dimension::X, 1}, {1.0});
   auto b = makeVariable<Data::Variance>({Dimension::X, 1}, {2.0});
@@ -171,6 +243,14 @@ TEST(Variable, operator_times_equal) {
   EXPECT_EQ(a.unit(), Unit::Id::Area);
 }
 
+TEST(Variable, operator_times_equal_unit_scale) {
+  auto a = makeVariable<Coord::X>({Dimension::X, 2}, {2.0, 3.0});
+  a.setUnit(Unit(Unit::Id::Length, 1e-3));
+  EXPECT_NO_THROW(a *= a);
+  EXPECT_EQ(a.get<Data::Value>()[0], 4.0);
+  EXPECT_EQ(a.unit(), Unit(Unit::Id::Area, 1e-6));
+}
+
 TEST(Variable, setSlice) {
   Dimensions dims(Dimension::Tof, 1);
   const auto parent = makeVariable<Data::Value>(
@@ -407,6 +487,62 @@ TEST(Variable, concatenate_unit_fail) {
   EXPECT_NO_THROW(concatenate(a, b, Dimension::X));
 }
 
+TEST(Variable, concatenate_move_strings) {
+  // Large enough for copying in parallel.
+  std::vector<std::string> strings(300);
+  for (gsl::index i = 0; i < static_cast<gsl::index>(strings.size()); ++i)
+    strings[i] = "a long string that does not fit into SSO " +
+                 std::to_string(i);
+  auto a = makeVariable<Data::String>({Dim::X, 300}, strings.begin(),
+                                      strings.end());
+  auto b(a);
+  b.data(); // Unshare.
+  const auto copied = concatenate(a, b, Dim::X);
+  const auto shared(b);
+  const auto moved = concatenate(std::move(a), std::move(b), Dim::X);
+  EXPECT_EQ(moved, copied);
+  EXPECT_EQ(moved.get<const Data::String>()[299], strings[299]);
+  EXPECT_EQ(moved.get<const Data::String>()[599], strings[299]);
+  // Shared data is copied, not moved from.
+  EXPECT_EQ(shared.get<const Data::String>()[299], strings[299]);
+}
+
+TEST(Variable, permute_and_filter_move_strings) {
+  auto var = makeVariable<Data::String>(
+      {Dim::X, 3}, {std::string("a"), std::string("b"), std::string("c")});
+  auto permuted = permute(Variable(var), Dim::X, {2, 0, 1});
+  EXPECT_EQ(permuted, makeVariable<Data::String>({Dim::X, 3},
+                                                 {std::string("c"),
+                                                  std::string("a"),
+                                                  std::string("b")}));
+  const auto mask = makeVariable<Coord::Mask>({Dim::X, 3}, {1, 0, 1});
+  auto filtered = filter(std::move(permuted), mask);
+  EXPECT_EQ(filtered,
+            makeVariable<Data::String>(
+                {Dim::X, 2}, {std::string("c"), std::string("b")}));
+  auto sliced = slice(std::move(filtered), Dim::X, 1);
+  EXPECT_EQ(sliced.get<const Data::String>()[0], "b");
+}
+
+TEST(Variable, permute_partial_or_repeated_indices) {
+  auto var = makeVariable<Data::String>(
+      {Dim::X, 3}, {std::string("a"), std::string("b"), std::string("c")});
+  // Slices beyond the given indices are preserved.
+  EXPECT_EQ(permute(Variable(var), Dim::X, {2}),
+            makeVariable<Data::String>({Dim::X, 3},
+                                       {std::string("c"), std::string("b"),
+                                        std::string("c")}));
+  EXPECT_EQ(permute(var, Dim::X, {1, 0}),
+            makeVariable<Data::String>({Dim::X, 3},
+                                       {std::string("b"), std::string("a"),
+                                        std::string("c")}));
+  // Repeated indices do not read moved-from elements.
+  EXPECT_EQ(permute(Variable(var), Dim::X, {1, 1, 0}),
+            makeVariable<Data::String>({Dim::X, 3},
+                                       {std::string("b"), std::string("b"),
+                                        std::string("a")}));
+}
+
 TEST(Variable, rebin) {
   auto var = makeVariable<Data::Value>({Dim::X, 2}, {1.0, 2.0});
   const auto oldEdge = makeVariable<Coord::X>({Dim::X, 3}, {1.0, 2.0, 3.0});
@@ -418,6 +554,463 @@ TEST(Variable, rebin) {
   EXPECT_EQ(rebinned.get<const Data::Value>()[0], 3.0);
 }
 
+TEST(Variable, cumsum_inner) {
+  auto var = makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 3}},
+                                       {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+  auto summed = cumsum(var, Dim::X);
+  EXPECT_TRUE(equals(summed.get<const Data::Value>(),
+                     {1.0, 3.0, 6.0, 4.0, 9.0, 15.0}));
+  EXPECT_TRUE(equals(var.get<const Data::Value>(),
+                     {1.0, 2.0, 3.0, 4.0, 5.0, 6.0}));
+}
+
+TEST(Variable, cumsum_outer) {
+  auto var = makeVariable<Data::Int>({{Dim::Y, 3}, {Dim::X, 2}},
+                                     {1, 2, 3, 4, 5, 6});
+  auto summed = cumsum(var, Dim::Y);
+  EXPECT_TRUE(equals(summed.get<const Data::Int>(), {1, 2, 4, 6, 9, 12}));
+}
+
+TEST(Variable, cumsum_zero_extent) {
+  const auto var = makeVariable<Data::Value>({{Dim::Y, 3}, {Dim::X, 0}});
+  EXPECT_EQ(cumsum(var, Dim::Y), var);
+  EXPECT_EQ(cumsum(var, Dim::X), var);
+}
+
+TEST(Variable, cumsum_fail) {
+  auto var = makeVariable<Data::Value>({Dim::X, 2}, {1.0, 2.0});
+  EXPECT_THROW(cumsum(var, Dim::Y), dataset::except::DimensionNotFoundError);
+  auto strings = makeVariable<Data::String>({Dim::X, 1}, {std::string("a")});
+  EXPECT_THROW_MSG(cumsum(strings, Dim::X), std::runtime_error,
+                   "Not an arithmetic type. Cannot compute cumulative sum.");
+}
+
+TEST(Variable, sparse_roundtrip) {
+  const auto dense = makeVariable<Data::Value>(
+      {{Dim::Y, 2}, {Dim::X, 4}}, {0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 2.0});
+  auto sparse = toSparse(dense);
+  EXPECT_TRUE(sparse.isSparse());
+  EXPECT_FALSE(dense.isSparse());
+  EXPECT_EQ(sparse, dense);
+  EXPECT_EQ(dense, sparse);
+  EXPECT_THROW_MSG(sparse.get<const Data::Value>(), std::runtime_error,
+                   "Cannot access data of sparse variable directly. Convert to "
+                   "dense first.");
+  const auto back = toDense(sparse);
+  EXPECT_FALSE(back.isSparse());
+  EXPECT_TRUE(equals(back.get<const Data::Value>(),
+                     {0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 2.0}));
+
+  auto ints = makeVariable<Data::Int>({Dim::X, 2}, {0, 1});
+  EXPECT_THROW_MSG(ints.makeSparse(), std::runtime_error,
+                   "Sparse storage is only supported for element type "
+                   "double.");
+}
+
+TEST(Variable, sparse_arithmetic) {
+  const Dimensions dims{{Dim::Y, 2}, {Dim::X, 8}};
+  std::vector<double> a(16, 0.0);
+  std::vector<double> b(16, 0.0);
+  a[1] = 1.0;
+  a[9] = 2.0;
+  b[1] = 3.0;
+  b[14] = 4.0;
+  auto sparse = toSparse(makeVariable<Data::Value>(dims, a.begin(), a.end()));
+  const auto other =
+      toSparse(makeVariable<Data::Value>(dims, b.begin(), b.end()));
+
+  sparse += other;
+  EXPECT_TRUE(sparse.isSparse());
+  a[1] += 3.0;
+  a[14] += 4.0;
+  EXPECT_EQ(sparse, makeVariable<Data::Value>(dims, a.begin(), a.end()));
+
+  sparse -= other;
+  EXPECT_TRUE(sparse.isSparse());
+  a[1] -= 3.0;
+  a[14] -= 4.0;
+  EXPECT_EQ(sparse, makeVariable<Data::Value>(dims, a.begin(), a.end()));
+
+  // Multiplication keeps the sparsity pattern, also with broadcast.
+  sparse *= makeVariable<Data::Value>({Dim::X, 8},
+                                      {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+  EXPECT_TRUE(sparse.isSparse());
+  a[1] *= 2.0;
+  a[9] *= 2.0;
+  EXPECT_EQ(sparse, makeVariable<Data::Value>(dims, a.begin(), a.end()));
+
+  // Dense LHS, only non-zeros of the RHS are touched.
+  auto dense = makeVariable<Data::Value>(dims, a.begin(), a.end());
+  dense += other;
+  EXPECT_FALSE(dense.isSparse());
+  EXPECT_EQ(dense.get<const Data::Value>()[1], a[1] + 3.0);
+  EXPECT_EQ(dense.get<const Data::Value>()[14], 4.0);
+
+  // Adding dense data fills in the zeros, the result is dense.
+  sparse += dense;
+  EXPECT_FALSE(sparse.isSparse());
+}
+
+TEST(Variable, sparse_times_equal_different_element_type) {
+  auto sparse = toSparse(makeVariable<Data::Value>({Dim::X, 2}, {0.0, 1.0}));
+  EXPECT_THROW_MSG(sparse *= makeVariable<Data::Int>({Dim::X, 2}, {1, 2}),
+                   std::runtime_error,
+                   "Cannot apply arithmetic operation to Variables: Underlying "
+                   "data types do not match.");
+}
+
+TEST(Variable, sparse_densify_above_threshold) {
+  const Dimensions dims{Dim::X, 4};
+  auto a = toSparse(makeVariable<Data::Value>(dims, {1.0, 0.0, 0.0, 0.0}));
+  const auto b =
+      toSparse(makeVariable<Data::Value>(dims, {0.0, 1.0, 0.0, 0.0}));
+  a += b;
+  EXPECT_TRUE(a.isSparse());
+  a += toSparse(makeVariable<Data::Value>(dims, {0.0, 0.0, 1.0, 0.0}));
+  EXPECT_FALSE(a.isSparse());
+  EXPECT_TRUE(equals(a.get<const Data::Value>(), {1.0, 1.0, 1.0, 0.0}));
+}
+
+TEST(Variable, sparse_slice_and_concatenate) {
+  const auto dense = makeVariable<Data::Value>(
+      {{Dim::Y, 3}, {Dim::X, 3}},
+      {0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 2.0, 0.0, 3.0});
+  const auto sparse = toSparse(dense);
+
+  auto row = slice(sparse, Dim::Y, 2);
+  EXPECT_TRUE(row.isSparse());
+  EXPECT_EQ(row, slice(dense, Dim::Y, 2));
+  auto columns = slice(sparse, Dim::X, 1, 3);
+  EXPECT_TRUE(columns.isSparse());
+  EXPECT_EQ(columns, slice(dense, Dim::X, 1, 3));
+
+  auto joined = concatenate(sparse, sparse, Dim::X);
+  EXPECT_TRUE(joined.isSparse());
+  EXPECT_EQ(joined, concatenate(dense, dense, Dim::X));
+
+  EXPECT_THROW_MSG(sparse(Dim::X, 0), std::runtime_error,
+                   "Cannot create view of sparse data. Use slice() or "
+                   "convert to dense first.");
+}
+
+TEST(Variable, sparse_permute_and_filter) {
+  const auto dense = makeVariable<Data::Value>(
+      {{Dim::Z, 2}, {Dim::Y, 3}, {Dim::X, 3}},
+      {0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 2.0, 0.0, 3.0,
+       4.0, 0.0, 0.0, 0.0, 5.0, 6.0, 0.0, 0.0, 7.0});
+  const auto sparse = toSparse(dense);
+  for (const auto dim : {Dim::Z, Dim::Y, Dim::X}) {
+    const auto extent = dense.dimensions()[dim];
+    std::vector<gsl::index> reversed(extent);
+    for (gsl::index i = 0; i < extent; ++i)
+      reversed[i] = extent - 1 - i;
+    for (const auto &indices : {reversed, std::vector<gsl::index>{1},
+                                std::vector<gsl::index>{1, 1}}) {
+      auto permuted = permute(sparse, dim, indices);
+      EXPECT_TRUE(permuted.isSparse());
+      EXPECT_EQ(permuted, permute(dense, dim, indices));
+    }
+    auto mask = makeVariable<Coord::Mask>({dim, extent});
+    mask.get<Coord::Mask>()[extent - 1] = 1;
+    mask.get<Coord::Mask>()[0] = 1;
+    auto filtered = filter(sparse, mask);
+    EXPECT_TRUE(filtered.isSparse());
+    EXPECT_EQ(filtered, filter(dense, mask));
+  }
+}
+
+TEST(Variable, sparse_rebin) {
+  const auto dense = makeVariable<Data::Value>(
+      {{Dim::Y, 2}, {Dim::X, 4}}, {0.0, 1.0, 0.0, 4.0, 0.0, 0.0, 2.0, 0.0});
+  const auto oldEdge =
+      makeVariable<Coord::X>({Dim::X, 5}, {0.0, 1.0, 2.0, 3.0, 4.0});
+  const auto newEdge = makeVariable<Coord::X>({Dim::X, 3}, {0.0, 1.5, 4.0});
+  auto rebinned = rebin(toSparse(dense), oldEdge, newEdge);
+  EXPECT_TRUE(rebinned.isSparse());
+  EXPECT_EQ(rebinned.dimensions(), (Dimensions{{Dim::Y, 2}, {Dim::X, 2}}));
+  EXPECT_EQ(rebinned, makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}},
+                                                {0.5, 4.5, 0.0, 2.0}));
+}
+
+TEST(Variable, constant) {
+  const Dimensions dims{{Dim::Y, 2}, {Dim::X, 3}};
+  auto var = makeConstantVariable<Data::Value>(dims, 2.0);
+  EXPECT_TRUE(var.isConstant());
+  EXPECT_EQ(var.dimensions(), dims);
+  EXPECT_EQ(var, makeVariable<Data::Value>(dims, {2, 2, 2, 2, 2, 2}));
+  EXPECT_EQ(makeVariable<Data::Value>(dims, {2, 2, 2, 2, 2, 2}), var);
+  EXPECT_NE(var, makeConstantVariable<Data::Value>(dims, 3.0));
+  // Nothing of the size of the dimensions is stored, so there is no raw
+  // access to the values.
+  EXPECT_THROW_MSG(var.get<const Data::Value>(), std::runtime_error,
+                   "Cannot access data of constant variable directly. "
+                   "Convert to dense first.");
+  EXPECT_TRUE(var.isConstant());
+  EXPECT_TRUE(
+      equals(toDense(var).get<const Data::Value>(), {2, 2, 2, 2, 2, 2}));
+
+  // Const slices read the single value via a broadcasting view.
+  const auto &constVar = var;
+  EXPECT_EQ(
+      makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}}, {2, 2, 2, 2}),
+      constVar(Dim::X, 1, 3));
+  EXPECT_EQ(constVar(Dim::X, 1, 3)(Dim::Y, 1).get<const Data::Value>()[1],
+            2.0);
+  auto sliced = slice(var, Dim::Y, 1);
+  EXPECT_TRUE(sliced.isConstant());
+  EXPECT_EQ(sliced.dimensions(), Dimensions(Dim::X, 3));
+}
+
+TEST(Variable, constant_uniform_operations) {
+  const Dimensions dims{{Dim::Y, 2}, {Dim::X, 3}};
+  auto var = makeConstantVariable<Data::Value>(dims, 2.0);
+  var += makeConstantVariable<Data::Value>(dims, 1.0);
+  var *= makeConstantVariable<Data::Value>(Dimensions(Dim::X, 3), 2.0);
+  var -= makeConstantVariable<Data::Int>({}, 1);
+  EXPECT_TRUE(var.isConstant());
+  EXPECT_EQ(var, makeConstantVariable<Data::Value>(dims, 5.0));
+}
+
+TEST(Variable, constant_as_operand) {
+  auto var = makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}},
+                                       {1.0, 2.0, 3.0, 4.0});
+  var += makeConstantVariable<Data::Value>({Dim::X, 2}, 1.0);
+  var *= makeConstantVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}}, 2.0);
+  EXPECT_TRUE(equals(var.get<const Data::Value>(), {4.0, 6.0, 8.0, 10.0}));
+
+  auto sparse = toSparse(
+      makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}}, {0, 1, 0, 0}));
+  sparse *= makeConstantVariable<Data::Value>({}, 3.0);
+  EXPECT_TRUE(sparse.isSparse());
+  EXPECT_EQ(sparse, makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}},
+                                              {0, 3, 0, 0}));
+}
+
+TEST(Variable, constant_materialized_on_write) {
+  auto var = makeConstantVariable<Data::Value>({Dim::X, 3}, 1.0);
+  auto copy(var);
+  var += makeVariable<Data::Value>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  EXPECT_FALSE(var.isConstant());
+  EXPECT_TRUE(equals(var.get<const Data::Value>(), {2.0, 3.0, 4.0}));
+
+  copy.get<Data::Value>()[1] = 5.0;
+  EXPECT_FALSE(copy.isConstant());
+  EXPECT_TRUE(equals(copy.get<const Data::Value>(), {1.0, 5.0, 1.0}));
+
+  auto other =
+      makeConstantVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}}, 1.0);
+  other(Dim::X, 1).copyFrom(
+      makeVariable<Data::Value>({Dim::Y, 2}, {7.0, 8.0}));
+  EXPECT_FALSE(other.isConstant());
+  EXPECT_TRUE(equals(other.get<const Data::Value>(), {1.0, 7.0, 1.0, 8.0}));
+}
+
+TEST(Variable, progression) {
+  auto var = makeArithmeticProgression<Coord::X>(Dim::X, 4, 1.0, 0.5);
+  EXPECT_TRUE(var.isProgression());
+  EXPECT_EQ(var.dimensions(), Dimensions(Dim::X, 4));
+  EXPECT_TRUE(equals(var.get<const Coord::X>(), {1.0, 1.5, 2.0, 2.5}));
+  EXPECT_EQ(var, makeVariable<Coord::X>({Dim::X, 4}, {1.0, 1.5, 2.0, 2.5}));
+  EXPECT_EQ(var, makeArithmeticProgression<Coord::X>(Dim::X, 4, 1.0, 0.5));
+  EXPECT_NE(var, makeArithmeticProgression<Coord::X>(Dim::X, 4, 1.0, 1.0));
+  EXPECT_NE(var, makeGeometricProgression<Coord::X>(Dim::X, 4, 1.0, 1.5));
+  const auto single = makeArithmeticProgression<Coord::X>(Dim::X, 1, 1.0, 0.5);
+  EXPECT_EQ(single, makeConstantVariable<Coord::X>({Dim::X, 1}, 1.0));
+  EXPECT_EQ(makeConstantVariable<Coord::X>({Dim::X, 1}, 1.0), single);
+  const auto constant = makeConstantVariable<Coord::X>({Dim::X, 4}, 1.0);
+  EXPECT_NE(var, constant);
+  EXPECT_NE(constant, var);
+
+  auto geometric = makeGeometricProgression<Coord::X>(Dim::X, 4, 1.0, 10.0);
+  EXPECT_TRUE(
+      equals(geometric.get<const Coord::X>(), {1.0, 10.0, 100.0, 1000.0}));
+
+  EXPECT_THROW_MSG(makeArithmeticProgression<Coord::X>(Dim::X, 4, 1.0, -1.0),
+                   std::runtime_error, "Progression must be increasing.");
+}
+
+TEST(Variable, progression_lower_index) {
+  const Progression linear{Progression::Kind::Arithmetic, 1.0, 0.1};
+  EXPECT_EQ(linear.lowerIndex(1.0), 0);
+  EXPECT_EQ(linear.lowerIndex(1.3), 3);
+  EXPECT_EQ(linear.lowerIndex(1.35), 3);
+  EXPECT_EQ(linear.lowerIndex(0.95), -1);
+  const Progression log{Progression::Kind::Geometric, 1.0, 10.0};
+  EXPECT_EQ(log.lowerIndex(1000.0), 3);
+  EXPECT_EQ(log.lowerIndex(999.0), 2);
+  EXPECT_LT(log.lowerIndex(0.0), 0);
+}
+
+TEST(Variable, progression_lower_index_non_finite) {
+  constexpr auto lowest = std::numeric_limits<gsl::index>::min();
+  constexpr auto highest = std::numeric_limits<gsl::index>::max() - 1;
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  for (const auto kind :
+       {Progression::Kind::Arithmetic, Progression::Kind::Geometric}) {
+    const Progression progression{kind, 1.0, 2.0};
+    EXPECT_EQ(progression.lowerIndex(nan), lowest);
+    EXPECT_EQ(progression.lowerIndex(-inf), lowest);
+    EXPECT_EQ(progression.lowerIndex(inf), highest);
+    EXPECT_EQ(progression.lowerIndex(-1e300), lowest);
+    EXPECT_EQ(progression.lowerIndex(1e300),
+              kind == Progression::Kind::Arithmetic ? highest : 996);
+  }
+}
+
+TEST(Variable, progression_slice_and_write) {
+  auto var = makeArithmeticProgression<Coord::X>(Dim::X, 4, 1.0, 0.5);
+  auto sliced = slice(var, Dim::X, 1, 3);
+  EXPECT_TRUE(sliced.isProgression());
+  EXPECT_EQ(sliced, makeArithmeticProgression<Coord::X>(Dim::X, 2, 1.5, 0.5));
+  const auto &constVar = var;
+  EXPECT_EQ(makeVariable<Coord::X>({Dim::X, 2}, {2.0, 2.5}),
+            constVar(Dim::X, 2, 4));
+
+  var.get<Coord::X>()[0] = 0.0;
+  EXPECT_FALSE(var.isProgression());
+  EXPECT_TRUE(equals(var.get<const Coord::X>(), {0.0, 1.5, 2.0, 2.5}));
+}
+
+TEST(Variable, rebin_progression) {
+  auto var = makeVariable<Data::Value>({Dim::X, 4}, {1.0, 2.0, 3.0, 4.0});
+  const auto oldEdge = makeArithmeticProgression<Coord::X>(Dim::X, 5, 0.0, 1.0);
+  const auto newEdge = makeArithmeticProgression<Coord::X>(Dim::X, 3, 1.0, 1.5);
+  auto rebinned = rebin(var, oldEdge, newEdge);
+  EXPECT_TRUE(equals(rebinned.get<const Data::Value>(), {3.5, 5.5}));
+  auto reference = rebin(var, toDense(oldEdge), toDense(newEdge));
+  EXPECT_EQ(rebinned, reference);
+}
+
+TEST(Variable, lazy) {
+  const auto input = makeVariable<Data::Value>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  std::atomic<gsl::index> calls{0};
+  auto var = makeLazyVariable<Data::Value>(input, [&calls](const double x) {
+    ++calls;
+    return 2.0 * x;
+  });
+  EXPECT_TRUE(var.isLazy());
+  EXPECT_EQ(var.dimensions(), input.dimensions());
+  EXPECT_EQ(calls, 0);
+  EXPECT_TRUE(equals(var.get<const Data::Value>(), {2.0, 4.0, 6.0}));
+  EXPECT_EQ(calls, 3);
+  // Values are cached after the first access.
+  EXPECT_EQ(var, makeVariable<Data::Value>({Dim::X, 3}, {2.0, 4.0, 6.0}));
+  EXPECT_EQ(calls, 3);
+  EXPECT_TRUE(var.isLazy());
+  const auto constant = makeConstantVariable<Data::Value>({Dim::X, 3}, 2.0);
+  EXPECT_NE(var, constant);
+  EXPECT_NE(constant, var);
+  const auto twos = makeLazyVariable<Data::Value>(
+      input, [](const double) { return 2.0; });
+  EXPECT_EQ(twos, constant);
+  EXPECT_EQ(constant, twos);
+}
+
+TEST(Variable, lazy_binary_broadcast) {
+  const auto a = makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}},
+                                           {1.0, 2.0, 3.0, 4.0});
+  const auto b = makeVariable<Data::Value>({Dim::X, 2}, {10.0, 20.0});
+  auto var = makeLazyVariable<Data::Value>(a, b, std::plus<double>());
+  EXPECT_EQ(var, makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}},
+                                           {11.0, 22.0, 13.0, 24.0}));
+  EXPECT_THROW_MSG(makeLazyVariable<Data::Value>(b, a, std::plus<double>()),
+                   std::runtime_error,
+                   "Inputs of lazy variable must be broadcastable to its "
+                   "dimensions.");
+}
+
+TEST(Variable, lazy_slice) {
+  const auto input = makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 3}},
+                                               {1, 2, 3, 4, 5, 6});
+  std::atomic<gsl::index> calls{0};
+  auto var = makeLazyVariable<Data::Value>(input, [&calls](const double x) {
+    ++calls;
+    return -x;
+  });
+  // Slices stay lazy and compute only the requested part.
+  auto row = slice(var, Dim::Y, 1);
+  EXPECT_TRUE(row.isLazy());
+  EXPECT_TRUE(equals(row.get<const Data::Value>(), {-4.0, -5.0, -6.0}));
+  EXPECT_EQ(calls, 3);
+  auto range = slice(var, Dim::X, 1, 3);
+  EXPECT_TRUE(range.isLazy());
+  EXPECT_EQ(range, makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 2}},
+                                             {-2, -3, -5, -6}));
+  EXPECT_EQ(calls, 7);
+}
+
+TEST(Variable, lazy_slice_view) {
+  const auto input = makeVariable<Data::Value>({{Dim::Y, 4}, {Dim::X, 3}},
+                                               {1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                                11, 12});
+  std::atomic<gsl::index> calls{0};
+  const auto var = makeLazyVariable<Data::Value>(
+      input, [&calls](const double x) {
+        ++calls;
+        return -x;
+      });
+  // Const slice views compute only the viewed range.
+  const auto row = var(Dim::Y, 3);
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(Variable(row),
+            makeVariable<Data::Value>({Dim::X, 3}, {-10, -11, -12}));
+  const auto column = var(Dim::X, 1, 2);
+  EXPECT_EQ(calls, 7);
+  EXPECT_EQ(Variable(column),
+            makeVariable<Data::Value>({{Dim::Y, 4}, {Dim::X, 1}},
+                                      {-2, -5, -8, -11}));
+  // Repeated views reuse the computed range.
+  EXPECT_EQ(var(Dim::Y, 3), row);
+  EXPECT_EQ(calls, 7);
+}
+
+TEST(Variable, lazy_comparison) {
+  const auto input = makeVariable<Data::Value>({{Dim::Y, 2}, {Dim::X, 3}},
+                                               {1, 2, 3, 4, 5, 6});
+  const auto a = makeLazyVariable<Data::Value>(
+      input, [](const double x) { return 2.0 * x; });
+  const auto b = makeLazyVariable<Data::Value>(
+      input, [](const double x) { return x + x; });
+  const auto c = makeLazyVariable<Data::Value>(
+      input, [](const double x) { return -x; });
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(a(Dim::Y, 1), b(Dim::Y, 1));
+  EXPECT_NE(a(Dim::Y, 1), c(Dim::Y, 1));
+
+  const auto x = makeVariable<Data::Value>({Dim::X, 3}, {1.0, 2.0, 3.0});
+  const auto lazy = makeLazyVariable<Data::Value>(
+      x, [](const double v) { return 2.0 * v; });
+  const auto progression =
+      makeArithmeticProgression<Data::Value>(Dim::X, 3, 2.0, 2.0);
+  EXPECT_EQ(lazy, progression);
+  EXPECT_EQ(progression, lazy);
+  EXPECT_EQ(lazy(Dim::X, 1, 3), progression(Dim::X, 1, 3));
+  EXPECT_EQ(progression(Dim::X, 1, 3), lazy(Dim::X, 1, 3));
+  const auto other =
+      makeArithmeticProgression<Data::Value>(Dim::X, 3, 2.0, 1.0);
+  EXPECT_NE(lazy, other);
+  EXPECT_NE(other, lazy);
+}
+
+TEST(Variable, lazy_materialized_on_write) {
+  auto input = makeVariable<Data::Value>({Dim::X, 2}, {1.0, 2.0});
+  auto var = makeLazyVariable<Data::Value>(
+      input, [](const double x) { return x * x; });
+  // The recipe holds its own reference to the input buffer.
+  input.get<Data::Value>()[0] = 3.0;
+  EXPECT_EQ(var, makeVariable<Data::Value>({Dim::X, 2}, {1.0, 4.0}));
+
+  auto copy(var);
+  var += makeVariable<Data::Value>({Dim::X, 2}, {1.0, 1.0});
+  EXPECT_FALSE(var.isLazy());
+  EXPECT_TRUE(equals(var.get<const Data::Value>(), {2.0, 5.0}));
+  copy.get<Data::Value>()[1] = 0.0;
+  EXPECT_FALSE(copy.isLazy());
+  EXPECT_TRUE(equals(copy.get<const Data::Value>(), {1.0, 0.0}));
+}
+
 TEST(VariableSlice, strides) {
   auto var = makeVariable<Data::Value>({{Dim::Y, 3}, {Dim::X, 3}});
   EXPECT_EQ(var(Dim::X, 0).strides(), (std::vector<gsl::index>{3}));
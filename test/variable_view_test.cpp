@@ -102,3 +102,48 @@ TEST(VariableView, subview) {
   EXPECT_EQ(*it++, 4.0);
   EXPECT_EQ(*it++, 4.0);
 }
+
+TEST(VariableView, random_access) {
+  Dimensions dims({{Dim::Y, 3}, {Dim::X, 2}});
+  std::vector<double> variable(dims.volume());
+  std::iota(variable.begin(), variable.end(), 0);
+
+  Dimensions variableDims({{Dim::Y, 3}});
+  VariableView<double> view(variable.data(), variableDims, dims);
+  EXPECT_EQ(view[0], 0.0);
+  EXPECT_EQ(view[1], 2.0);
+  EXPECT_EQ(view[2], 4.0);
+
+  Dimensions subDims({{Dim::Y, 3}, {Dim::X, 2}});
+  VariableView<double> subView(view, subDims);
+  const std::vector<double> expected{0.0, 0.0, 2.0, 2.0, 4.0, 4.0};
+  for (gsl::index i = 0; i < 6; ++i)
+    EXPECT_EQ(subView[i], expected[i]);
+}
+
+TEST(VariableView, random_access_matches_iterator) {
+  Dimensions dims({{Dim::Z, 2}, {Dim::Y, 3}, {Dim::X, 4}});
+  std::vector<double> variable(dims.volume());
+  std::iota(variable.begin(), variable.end(), 0);
+
+  Dimensions transposed({{Dim::X, 4}, {Dim::Z, 2}, {Dim::Y, 3}});
+  VariableView<double> view(variable.data(), transposed, dims);
+  gsl::index i = 0;
+  for (const auto &value : view)
+    EXPECT_EQ(view[i++], value);
+  EXPECT_EQ(i, 24);
+}
+
+TEST(VariableView, for_each_pair) {
+  Dimensions dims({{Dim::Y, 3}, {Dim::X, 2}});
+  std::vector<double> a(dims.volume());
+  std::iota(a.begin(), a.end(), 0);
+  Dimensions bDims({{Dim::X, 2}, {Dim::Y, 3}});
+  std::vector<double> b(bDims.volume());
+  std::iota(b.begin(), b.end(), 0);
+
+  VariableView<double> viewA(a.data(), dims, dims);
+  VariableView<double> viewB(b.data(), dims, bDims);
+  viewA.for_each(viewB, [](double &x, const double y) { x += y; });
+  EXPECT_EQ(a, std::vector<double>({0.0, 4.0, 3.0, 7.0, 6.0, 10.0}));
+}